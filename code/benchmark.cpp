@@ -0,0 +1,1187 @@
+/**
+    benchmark.cpp : Microbenchmarks for the core utils primitives
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#include <utils/Buffer.hpp>
+#include <utils/File.hpp>
+#include <utils/Tokens.hpp>
+#include <utils/Staque.hpp>
+#include <utils/MpmcQueue.hpp>
+#include <utils/SpscQueue.hpp>
+#include <utils/TaskScheduler.hpp>
+#include <utils/TimerWheel.hpp>
+#include <utils/RateLimiter.hpp>
+#include <utils/KeyValuePair.hpp>
+#include <utils/IniFile.hpp>
+#include <utils/HttpHelpers.hpp>
+#include <utils/HttpRequest.hpp>
+#include <utils/HttpAccess.hpp>
+#include <utils/Sha1.hpp>
+#include <utils/Base64.hpp>
+#include <utils/DirectoryListing.hpp>
+#include <utils/Lock.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+// Each benchmark is sampled this many times and the median is reported
+#define SAMPLES   5
+// Target duration of a single sample in nanoseconds
+#define SAMPLENS  20000000ULL
+
+using namespace utils;
+using namespace std;
+
+struct Result
+{
+    string   name;
+    uint64_t iterations;
+    double   nsPerOp;
+    double   minNsPerOp;
+};
+
+struct Counter : public Lockable
+{
+    uint64_t value = 0;
+};
+
+struct SharedCounter : public BasicLockable< SharedLockPolicy >
+{
+    uint64_t value = 0;
+};
+
+// Keep the optimizer from discarding benchmark results
+template< typename type >
+static inline void Keep( type const &a_value )
+{
+    asm volatile( "" : : "r,m"( a_value ) : "memory" );
+}
+
+static uint64_t Now()
+{
+    return chrono::duration_cast< chrono::nanoseconds >(
+        chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+template< typename function >
+static uint64_t TimeRun( function &a_body, uint64_t a_iterations )
+{
+    uint64_t start = Now();
+    a_body( a_iterations );
+    return Now() - start;
+}
+
+template< typename function >
+static Result Measure( const char *a_name, function a_body )
+{
+    // Calibrate the iteration count so each sample runs for about SAMPLENS
+    uint64_t iterations = 1;
+    uint64_t elapsed    = TimeRun( a_body, iterations );
+    while( ( elapsed < ( SAMPLENS / 10 ) ) && ( iterations < ( 1ULL << 40 ) ) )
+    {
+        iterations *= 2;
+        elapsed = TimeRun( a_body, iterations );
+    }
+    if( elapsed > 0 )
+    {
+        iterations = max< uint64_t >( 1, ( iterations * SAMPLENS ) / elapsed );
+    }
+
+    vector< double > samples;
+    for( uint32_t s = 0; s < SAMPLES; ++s )
+    {
+        samples.push_back( static_cast< double >( TimeRun( a_body, iterations ) ) / iterations );
+    }
+    sort( samples.begin(), samples.end() );
+
+    Result result;
+    result.name       = a_name;
+    result.iterations = iterations;
+    result.nsPerOp    = samples[ SAMPLES / 2 ];
+    result.minNsPerOp = samples[ 0 ];
+    fprintf( stderr, "%-40s %12.2f ns/op\n", a_name, result.nsPerOp );
+    return result;
+}
+
+static string TempFile( const char *a_contents )
+{
+    char path[] = "/tmp/utils-bench-XXXXXX";
+    int  fd     = mkstemp( path );
+    if( fd < 0 )
+    {
+        return string();
+    }
+    size_t length = strlen( a_contents );
+    if( write( fd, a_contents, length ) != static_cast< ssize_t >( length ) )
+    {
+        close( fd );
+        unlink( path );
+        return string();
+    }
+    close( fd );
+    return string( path );
+}
+
+static void BenchBuffer( vector< Result > &a_results )
+{
+    uint8_t block[ 4096 ];
+    memset( block, 'x', sizeof( block ) );
+
+    a_results.push_back( Measure( "buffer.write_byte", [ & ]( uint64_t a_count )
+    {
+        Buffer buffer( 65536 );
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            if( !buffer.Write( static_cast< uint8_t >( i ) ) )
+            {
+                buffer.Clear();
+            }
+        }
+        Keep( buffer.Length() );
+    } ) );
+
+    a_results.push_back( Measure( "buffer.write_read_4k", [ & ]( uint64_t a_count )
+    {
+        Buffer  buffer( 65536 );
+        uint8_t output[ sizeof( block ) ];
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            buffer.Write( block, sizeof( block ) );
+            Keep( buffer.Read( output, sizeof( output ) ) );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "buffer.read_byte", [ & ]( uint64_t a_count )
+    {
+        Buffer  buffer( 65536 );
+        uint8_t value = 0;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            if( !buffer.Read( value ) )
+            {
+                buffer.Write( block, sizeof( block ) );
+            }
+            Keep( value );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "buffer.defragment_32k", [ & ]( uint64_t a_count )
+    {
+        Buffer  buffer( 65536 );
+        uint8_t output[ 1 ];
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            buffer.Clear();
+            for( uint32_t j = 0; j < 8; ++j )
+            {
+                buffer.Write( block, sizeof( block ) );
+            }
+            buffer.Read( output, sizeof( output ) );
+            buffer.Defragment();
+            Keep( buffer.Length() );
+        }
+    } ) );
+}
+
+static void BenchTokens( vector< Result > &a_results )
+{
+    string text;
+    for( uint32_t i = 0; i < 64; ++i )
+    {
+        text += "Host: example.com:8000 key=value 12345 ; comment\r\n";
+    }
+
+    a_results.push_back( Measure( "tokens.getline.buffer", [ & ]( uint64_t a_count )
+    {
+        Buffer buffer( 65536 );
+        string line;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            if( TokenTypes::Line != Tokens::GetLine( buffer, line ) )
+            {
+                buffer.Write( ( const uint8_t * )text.c_str(), text.length() );
+            }
+            Keep( line.length() );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "tokens.gettoken.buffer", [ & ]( uint64_t a_count )
+    {
+        Buffer buffer( 65536 );
+        string token;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            if( TokenTypes::NotFound == Tokens::GetToken( buffer, token ) )
+            {
+                buffer.Write( ( const uint8_t * )text.c_str(), text.length() );
+            }
+            Keep( token.length() );
+        }
+    } ) );
+
+    string path = TempFile( text.c_str() );
+    if( path.length() == 0 )
+    {
+        return;
+    }
+
+    a_results.push_back( Measure( "tokens.getline.file", [ & ]( uint64_t a_count )
+    {
+        File   file( path.c_str(), FileMode::DefaultRead );
+        string line;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            if( TokenTypes::Line != Tokens::GetLine( file, line ) )
+            {
+                file.Seek( 0 );
+            }
+            Keep( line.length() );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "tokens.gettoken.file", [ & ]( uint64_t a_count )
+    {
+        File   file( path.c_str(), FileMode::DefaultRead );
+        string token;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            if( TokenTypes::NotFound == Tokens::GetToken( file, token ) )
+            {
+                file.Seek( 0 );
+            }
+            Keep( token.length() );
+        }
+    } ) );
+
+    unlink( path.c_str() );
+}
+
+static void BenchStaque( vector< Result > &a_results )
+{
+    a_results.push_back( Measure( "staque.push_pop", [ & ]( uint64_t a_count )
+    {
+        Staque< uint64_t > staque;
+        uint64_t value = 0;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            staque.Push( i );
+            staque.Pop( value );
+            Keep( value );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "staque.enqueue_dequeue_string", [ & ]( uint64_t a_count )
+    {
+        Staque< string > staque;
+        string value( 64, 'x' );
+        string output;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            staque.Enqueue( value );
+            staque.Dequeue( output );
+            Keep( output.length() );
+        }
+    } ) );
+
+    // Same payload moved through the container instead of copied
+    a_results.push_back( Measure( "staque.enqueue_dequeue_string_move", [ & ]( uint64_t a_count )
+    {
+        Staque< string > staque;
+        string value( 64, 'x' );
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            staque.Enqueue( move( value ) );
+            staque.Dequeue( value );
+            Keep( value.length() );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "staque.getat_200", [ & ]( uint64_t a_count )
+    {
+        Staque< string > staque;
+        string value( "WORD" );
+        for( uint32_t i = 0; i < 200; ++i )
+        {
+            staque.Enqueue( value );
+        }
+        string output;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            staque.GetAt( static_cast< uint32_t >( i % 200 ), output );
+            Keep( output.length() );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "staque.blocks_push_pop", [ & ]( uint64_t a_count )
+    {
+        Staque< uint64_t, RecursiveLockPolicy, StaqueBlocks > staque;
+        uint64_t value = 0;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            staque.Push( i );
+            staque.Pop( value );
+            Keep( value );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "staque.blocks_enqueue_dequeue_string", [ & ]( uint64_t a_count )
+    {
+        Staque< string, RecursiveLockPolicy, StaqueBlocks > staque;
+        string value( 64, 'x' );
+        string output;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            staque.Enqueue( value );
+            staque.Dequeue( output );
+            Keep( output.length() );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "staque.blocks_getat_200", [ & ]( uint64_t a_count )
+    {
+        Staque< string, RecursiveLockPolicy, StaqueBlocks > staque;
+        string value( "WORD" );
+        for( uint32_t i = 0; i < 200; ++i )
+        {
+            staque.Enqueue( value );
+        }
+        string output;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            staque.GetAt( static_cast< uint32_t >( i % 200 ), output );
+            Keep( output.length() );
+        }
+    } ) );
+}
+
+static void BenchQueue( vector< Result > &a_results )
+{
+    a_results.push_back( Measure( "queue.mpmc_enqueue_dequeue", [ & ]( uint64_t a_count )
+    {
+        MpmcQueue< uint64_t > queue( 1024 );
+        uint64_t value = 0;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            queue.Enqueue( i );
+            queue.Dequeue( value );
+            Keep( value );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "queue.spsc_enqueue_dequeue", [ & ]( uint64_t a_count )
+    {
+        SpscQueue< uint64_t > queue( 1024 );
+        uint64_t value = 0;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            queue.Enqueue( i );
+            queue.Dequeue( value );
+            Keep( value );
+        }
+    } ) );
+
+    // Cross-thread handoff of shared_ptr values, as when passing sockets
+    // from an accept loop to workers; reported per value handed over
+    a_results.push_back( Measure( "queue.mpmc_handoff_shared_ptr", [ & ]( uint64_t a_count )
+    {
+        MpmcQueue< shared_ptr< uint64_t > > queue( 1024 );
+        auto item = make_shared< uint64_t >( 1 );
+        thread consumer( [ & ]()
+        {
+            shared_ptr< uint64_t > value;
+            uint64_t received = 0;
+            while( received < a_count )
+            {
+                if( queue.Dequeue( value ) )
+                {
+                    ++received;
+                }
+                else
+                {
+                    this_thread::yield();
+                }
+            }
+        } );
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            while( !queue.Enqueue( item ) )
+            {
+                this_thread::yield();
+            }
+        }
+        consumer.join();
+    } ) );
+
+    a_results.push_back( Measure( "queue.staque_handoff_shared_ptr", [ & ]( uint64_t a_count )
+    {
+        Staque< shared_ptr< uint64_t > > queue;
+        auto item = make_shared< uint64_t >( 1 );
+        thread consumer( [ & ]()
+        {
+            shared_ptr< uint64_t > value;
+            uint64_t received = 0;
+            while( received < a_count )
+            {
+                if( queue.Dequeue( value ) )
+                {
+                    ++received;
+                }
+                else
+                {
+                    this_thread::yield();
+                }
+            }
+        } );
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            queue.Enqueue( item );
+        }
+        consumer.join();
+    } ) );
+}
+
+static void BenchScheduler( vector< Result > &a_results )
+{
+    TaskScheduler scheduler( 2 );
+
+    a_results.push_back( Measure( "scheduler.post_drain", [ & ]( uint64_t a_count )
+    {
+        atomic< uint64_t > done( 0 );
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            scheduler.Post( [ &done ]() { done.fetch_add( 1, memory_order_relaxed ); } );
+        }
+        while( done.load( memory_order_acquire ) < a_count )
+        {
+            this_thread::yield();
+        }
+    } ) );
+
+    a_results.push_back( Measure( "scheduler.submit_get", [ & ]( uint64_t a_count )
+    {
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            Keep( scheduler.Submit( []( uint64_t a_value ) { return a_value + 1; }, i ).get() );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "scheduler.parallel_for_64k", [ & ]( uint64_t a_count )
+    {
+        vector< uint32_t > values( 65536, 1 );
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            scheduler.ParallelFor( 0, values.size(), 4096, [ & ]( size_t a_index )
+            {
+                values[ a_index ] += 1;
+            } );
+        }
+        Keep( values[ 0 ] );
+    } ) );
+}
+
+static void BenchTimerWheel( vector< Result > &a_results )
+{
+    TimerWheel wheel( 1 );
+
+    a_results.push_back( Measure( "timerwheel.schedule_cancel", [ & ]( uint64_t a_count )
+    {
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            Keep( wheel.Cancel( wheel.Schedule( static_cast< uint32_t >( i % 100000 ), []() {} ) ) );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "timerwheel.schedule_fire", [ & ]( uint64_t a_count )
+    {
+        // Spread the timers over ~16 s so they cascade through two wheels
+        TimerWheel fire( 1 );
+        uint64_t   fired = 0;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            fire.Schedule( static_cast< uint32_t >( ( i * 7919 ) % 16384 ) + 1, [ &fired ]() { ++fired; } );
+        }
+        fire.Tick( TimerWheel::Clock::now() + chrono::seconds( 20 ) );
+        Keep( fired );
+    } ) );
+}
+
+static void BenchRateLimiter( vector< Result > &a_results )
+{
+    RateLimiter limiter( 1000000.0, 1000000.0, 64 );
+    vector< string > clients;
+    for( uint32_t i = 0; i < 1024; ++i )
+    {
+        clients.push_back( "10.0." + to_string( i / 256 ) + "." + to_string( i % 256 ) );
+    }
+
+    a_results.push_back( Measure( "ratelimiter.request", [ & ]( uint64_t a_count )
+    {
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            Keep( limiter.Request( clients[ i & 1023 ] ) );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "ratelimiter.connect_disconnect", [ & ]( uint64_t a_count )
+    {
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            Keep( limiter.Connect( clients[ i & 1023 ] ) );
+            limiter.Disconnect( clients[ i & 1023 ] );
+        }
+    } ) );
+}
+
+static void BenchKeyValuePair( vector< Result > &a_results )
+{
+    typedef KeyValuePair< string, string > Pair;
+    shared_ptr< Pair > head;
+    for( int32_t i = 15; i >= 0; --i )
+    {
+        auto pair = make_shared< Pair >();
+        pair->Key()   = "HEADER-" + to_string( i );
+        pair->Value() = "value-" + to_string( i );
+        pair->Next()  = head;
+        head = pair;
+    }
+
+    a_results.push_back( Measure( "keyvaluepair.lookup_16", [ & ]( uint64_t a_count )
+    {
+        const string key( "HEADER-15" );
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            shared_ptr< Pair > start = head;
+            while( start && ( start->Key() != key ) )
+            {
+                start = start->Next();
+            }
+            Keep( start.get() );
+        }
+    } ) );
+}
+
+static void BenchIniFile( vector< Result > &a_results )
+{
+    string path = TempFile(
+        "[settings]\nport = 8000\naddress = 0.0.0.0\n\n"
+        "[path]\ndefault = ./public_html/\n\n"
+        "[mime-types]\n.html = text/html\n.css = text/css\n.js = text/javascript\n"
+        ".png = image/png\n.jpg = image/jpeg\n.json = application/json\nnone = application/octet-stream\n" );
+    if( path.length() == 0 )
+    {
+        return;
+    }
+
+    {
+        IniFile ini( path.c_str() );
+        a_results.push_back( Measure( "inifile.readvalue", [ & ]( uint64_t a_count )
+        {
+            string value;
+            for( uint64_t i = 0; i < a_count; ++i )
+            {
+                ini.ReadValue( "mime-types", ".json", value );
+                Keep( value.length() );
+            }
+        } ) );
+    }
+
+    unlink( path.c_str() );
+}
+
+static void BenchHttpHelpers( vector< Result > &a_results )
+{
+    a_results.push_back( Measure( "httphelpers.uridecode", [ & ]( uint64_t a_count )
+    {
+        const string uri( "/files/some%20directory/report%2B2026%20final.pdf?x=1+2" );
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            Keep( HttpHelpers::UriDecode( uri ).length() );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "httphelpers.uridecode_ext", [ & ]( uint64_t a_count )
+    {
+        string uri;
+        string ext;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            uri = "/files/some%20directory/report%2B2026%20final.pdf";
+            ext.clear();
+            Keep( HttpHelpers::UriDecode( uri, ext ) );
+        }
+    } ) );
+}
+
+// The SHA-1 and Base64 code HttpAccess used before the Sha1 and Base64
+// classes, kept as a baseline for their benchmarks
+static void LegacySha1( const uint8_t *a_data, size_t a_len, uint8_t a_output[ 20 ] )
+{
+    uint32_t h0 = 0x67452301;
+    uint32_t h1 = 0xEFCDAB89;
+    uint32_t h2 = 0x98BADCFE;
+    uint32_t h3 = 0x10325476;
+    uint32_t h4 = 0xC3D2E1F0;
+
+    uint64_t bitLen = static_cast< uint64_t >( a_len ) * 8;
+    size_t totalLen = a_len + 1;
+    while( ( totalLen % 64 ) != 56 )
+    {
+        ++totalLen;
+    }
+    vector< uint8_t > buffer( totalLen + 8, 0 );
+    for( size_t i = 0; i < a_len; ++i )
+    {
+        buffer[ i ] = a_data[ i ];
+    }
+    buffer[ a_len ] = 0x80;
+    for( size_t i = 0; i < 8; ++i )
+    {
+        buffer[ totalLen + i ] = static_cast< uint8_t >( ( bitLen >> ( 56 - ( i * 8 ) ) ) & 0xFF );
+    }
+
+    for( size_t chunk = 0; chunk < buffer.size(); chunk += 64 )
+    {
+        uint32_t w[ 80 ];
+        for( int i = 0; i < 16; ++i )
+        {
+            size_t index = chunk + ( i * 4 );
+            w[ i ] = ( buffer[ index ] << 24 ) |
+                     ( buffer[ index + 1 ] << 16 ) |
+                     ( buffer[ index + 2 ] << 8 ) |
+                     ( buffer[ index + 3 ] );
+        }
+        for( int i = 16; i < 80; ++i )
+        {
+            uint32_t value = w[ i - 3 ] ^ w[ i - 8 ] ^ w[ i - 14 ] ^ w[ i - 16 ];
+            w[ i ] = ( value << 1 ) | ( value >> 31 );
+        }
+
+        uint32_t a = h0;
+        uint32_t b = h1;
+        uint32_t c = h2;
+        uint32_t d = h3;
+        uint32_t e = h4;
+
+        for( int i = 0; i < 80; ++i )
+        {
+            uint32_t f = 0;
+            uint32_t k = 0;
+            if( i < 20 )
+            {
+                f = ( b & c ) | ( ( ~b ) & d );
+                k = 0x5A827999;
+            }
+            else if( i < 40 )
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if( i < 60 )
+            {
+                f = ( b & c ) | ( b & d ) | ( c & d );
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+
+            uint32_t temp = ( ( a << 5 ) | ( a >> 27 ) ) + f + e + k + w[ i ];
+            e = d;
+            d = c;
+            c = ( b << 30 ) | ( b >> 2 );
+            b = a;
+            a = temp;
+        }
+
+        h0 += a;
+        h1 += b;
+        h2 += c;
+        h3 += d;
+        h4 += e;
+    }
+
+    a_output[ 0 ] = ( h0 >> 24 ) & 0xFF;
+    a_output[ 1 ] = ( h0 >> 16 ) & 0xFF;
+    a_output[ 2 ] = ( h0 >> 8 ) & 0xFF;
+    a_output[ 3 ] = h0 & 0xFF;
+    a_output[ 4 ] = ( h1 >> 24 ) & 0xFF;
+    a_output[ 5 ] = ( h1 >> 16 ) & 0xFF;
+    a_output[ 6 ] = ( h1 >> 8 ) & 0xFF;
+    a_output[ 7 ] = h1 & 0xFF;
+    a_output[ 8 ] = ( h2 >> 24 ) & 0xFF;
+    a_output[ 9 ] = ( h2 >> 16 ) & 0xFF;
+    a_output[ 10 ] = ( h2 >> 8 ) & 0xFF;
+    a_output[ 11 ] = h2 & 0xFF;
+    a_output[ 12 ] = ( h3 >> 24 ) & 0xFF;
+    a_output[ 13 ] = ( h3 >> 16 ) & 0xFF;
+    a_output[ 14 ] = ( h3 >> 8 ) & 0xFF;
+    a_output[ 15 ] = h3 & 0xFF;
+    a_output[ 16 ] = ( h4 >> 24 ) & 0xFF;
+    a_output[ 17 ] = ( h4 >> 16 ) & 0xFF;
+    a_output[ 18 ] = ( h4 >> 8 ) & 0xFF;
+    a_output[ 19 ] = h4 & 0xFF;
+}
+
+static string LegacyBase64Encode( const uint8_t *a_data, size_t a_len )
+{
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    string out;
+    size_t i = 0;
+    while( i < a_len )
+    {
+        size_t remaining = a_len - i;
+        uint32_t octet_a = a_data[ i++ ];
+        uint32_t octet_b = ( remaining > 1 ) ? a_data[ i++ ] : 0;
+        uint32_t octet_c = ( remaining > 2 ) ? a_data[ i++ ] : 0;
+        uint32_t triple = ( octet_a << 16 ) | ( octet_b << 8 ) | octet_c;
+        out += table[ ( triple >> 18 ) & 0x3F ];
+        out += table[ ( triple >> 12 ) & 0x3F ];
+        out += ( remaining > 1 ) ? table[ ( triple >> 6 ) & 0x3F ] : '=';
+        out += ( remaining > 2 ) ? table[ triple & 0x3F ] : '=';
+    }
+    return out;
+}
+
+static int LegacyBase64Value( char a_char )
+{
+    if( ( a_char >= 'A' ) && ( a_char <= 'Z' ) )
+    {
+        return a_char - 'A';
+    }
+    if( ( a_char >= 'a' ) && ( a_char <= 'z' ) )
+    {
+        return a_char - 'a' + 26;
+    }
+    if( ( a_char >= '0' ) && ( a_char <= '9' ) )
+    {
+        return a_char - '0' + 52;
+    }
+    if( a_char == '+' )
+    {
+        return 62;
+    }
+    if( a_char == '/' )
+    {
+        return 63;
+    }
+    return -1;
+}
+
+static bool LegacyDecodeBase64( const string &a_input, string &a_output )
+{
+    a_output.clear();
+    int value = 0;
+    int bits  = -8;
+
+    for( size_t i = 0; i < a_input.length(); ++i )
+    {
+        char c = a_input[ i ];
+        if( Tokens::IsSpace( static_cast< uint8_t >( c ) ) )
+        {
+            continue;
+        }
+        if( c == '=' )
+        {
+            break;
+        }
+        int decoded = LegacyBase64Value( c );
+        if( decoded < 0 )
+        {
+            return false;
+        }
+        value = ( value << 6 ) + decoded;
+        bits += 6;
+        if( bits >= 0 )
+        {
+            a_output += static_cast< char >( ( value >> bits ) & 0xFF );
+            bits -= 8;
+        }
+    }
+    return true;
+}
+
+static void BenchSha1( vector< Result > &a_results )
+{
+    vector< uint8_t > data( 4096 );
+    for( size_t i = 0; i < data.size(); ++i )
+    {
+        data[ i ] = static_cast< uint8_t >( i * 131 );
+    }
+    uint8_t digest[ Sha1::DIGESTLEN ];
+
+    fprintf( stderr, "sha1: %s compression\n", Sha1::Accelerated()? "SHA extension": "portable" );
+    for( size_t length : { 24, 4096 } )
+    {
+        string name = "sha1.hash_" + to_string( length );
+        a_results.push_back( Measure( name.c_str(), [ & ]( uint64_t a_count )
+        {
+            for( uint64_t i = 0; i < a_count; ++i )
+            {
+                Sha1::Hash( data.data(), length, digest );
+                Keep( digest[ 0 ] );
+            }
+        } ) );
+        name = "sha1.legacy_" + to_string( length );
+        a_results.push_back( Measure( name.c_str(), [ & ]( uint64_t a_count )
+        {
+            for( uint64_t i = 0; i < a_count; ++i )
+            {
+                LegacySha1( data.data(), length, digest );
+                Keep( digest[ 0 ] );
+            }
+        } ) );
+    }
+}
+
+static void BenchBase64( vector< Result > &a_results )
+{
+    // An Authorization header's credentials and a larger payload
+    const string credentials( "alice:correct horse battery staple" );
+    vector< uint8_t > data( 4096 );
+    for( size_t i = 0; i < data.size(); ++i )
+    {
+        data[ i ] = static_cast< uint8_t >( i * 131 );
+    }
+    string header;
+    Base64::Encode( reinterpret_cast< const uint8_t * >( credentials.data() ), credentials.length(), header );
+    string block;
+    Base64::Encode( data.data(), data.size(), block );
+
+    a_results.push_back( Measure( "base64.encode_4096", [ & ]( uint64_t a_count )
+    {
+        string out;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            out.clear();
+            Base64::Encode( data.data(), data.size(), out );
+            Keep( out.length() );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "base64.encode_legacy_4096", [ & ]( uint64_t a_count )
+    {
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            Keep( LegacyBase64Encode( data.data(), data.size() ).length() );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "base64.decode_header", [ & ]( uint64_t a_count )
+    {
+        string out;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            Keep( Base64::Decode( header, out ) );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "base64.decode_legacy_header", [ & ]( uint64_t a_count )
+    {
+        string out;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            Keep( LegacyDecodeBase64( header, out ) );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "base64.decode_4096", [ & ]( uint64_t a_count )
+    {
+        string out;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            Keep( Base64::Decode( block, out ) );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "base64.decode_legacy_4096", [ & ]( uint64_t a_count )
+    {
+        string out;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            Keep( LegacyDecodeBase64( block, out ) );
+        }
+    } ) );
+}
+
+static void BenchHttpAccess( vector< Result > &a_results )
+{
+    // alice:secret using the {SHA} scheme, bob:secret in plain text
+    string path = TempFile(
+        "alice:{SHA}5en6G6MezRroT3XKqkdPOmY/BfQ=\n"
+        "bob:{PLAIN}secret\n" );
+    string iniPath = TempFile( ( "[settings]\naccess = " + path + "\n" ).c_str() );
+    if( ( path.length() == 0 ) || ( iniPath.length() == 0 ) )
+    {
+        return;
+    }
+
+    {
+        IniFile    ini( iniPath.c_str() );
+        HttpAccess access;
+        access.Configure( ini );
+
+        auto authorize = [ & ]( const char *a_name, const char *a_header )
+        {
+            HttpRequest request;
+            auto header = make_shared< HttpRequest::Header >();
+            header->Key()   = "AUTHORIZATION";
+            header->Value() = a_header;
+            request.Meta()  = header;
+            a_results.push_back( Measure( a_name, [ & ]( uint64_t a_count )
+            {
+                for( uint64_t i = 0; i < a_count; ++i )
+                {
+                    Keep( access.IsAuthorized( request ) );
+                }
+            } ) );
+        };
+
+        // Exercises Base64 decode of the header plus two SHA-1 digests
+        authorize( "httpaccess.authorize_sha1", "Basic YWxpY2U6c2VjcmV0" );
+        authorize( "httpaccess.authorize_plain", "Basic Ym9iOnNlY3JldA==" );
+    }
+
+    unlink( iniPath.c_str() );
+    unlink( path.c_str() );
+}
+
+// How HttpRequest listed a directory before DirectoryListing, kept as a
+// baseline: readdir, a sorted vector of strings, and a copy per escape
+static size_t LegacyListing( const string &a_path, string &a_output )
+{
+    DIR *dir = opendir( a_path.c_str() );
+    if( nullptr == dir )
+    {
+        return 0;
+    }
+    struct dirent *entry;
+    vector< string > listing;
+    while( ( entry = readdir( dir ) ) != nullptr )
+    {
+        string name = entry->d_name;
+        if( ( entry->d_type == DT_LNK ) || ( entry->d_name[ 0 ] == '.' ) )
+        {
+            continue;
+        }
+        if( entry->d_type == DT_DIR )
+        {
+            name += '/';
+        }
+        listing.push_back( name );
+    }
+    closedir( dir );
+    sort( listing.begin(), listing.end() );
+    for( auto &name : listing )
+    {
+        a_output += "<div class=\"entry\">\n<a class=\"entry-link\" href=\"";
+        if( name.back() == '/' )
+        {
+            a_output += HttpHelpers::UriEncode( name.substr( 0, name.size() - 1 ) ).c_str();
+            a_output += "/";
+        }
+        else
+        {
+            a_output += HttpHelpers::UriEncode( name ).c_str();
+        }
+        a_output += "\"><span class=\"bullet\">• </span>";
+        a_output += HttpHelpers::HtmlEscape( name ).c_str();
+        a_output += "</a></div>\n";
+    }
+    return listing.size();
+}
+
+static void BenchListing( vector< Result > &a_results )
+{
+    char path[] = "/tmp/utils-bench-XXXXXX";
+    if( nullptr == mkdtemp( path ) )
+    {
+        return;
+    }
+    const string directory( path );
+    const uint32_t files = 2000;
+    char name[ 64 ];
+    for( uint32_t i = 0; i < files; ++i )
+    {
+        snprintf( name, sizeof( name ), "/report %04u & notes.txt", ( i * 7919 ) % files );
+        close( open( ( directory + name ).c_str(), O_CREAT | O_WRONLY, 0644 ) );
+    }
+    // Age the directory so the cache accepts it
+    timeval times[ 2 ] = { { 1000000000, 0 }, { 1000000000, 0 } };
+    utimes( directory.c_str(), times );
+
+    a_results.push_back( Measure( "listing.legacy_2000", [ & ]( uint64_t a_count )
+    {
+        string out;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            out.clear();
+            Keep( LegacyListing( directory, out ) );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "listing.read_render_2000", [ & ]( uint64_t a_count )
+    {
+        DirectoryListing::Listing listing;
+        string out;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            out.clear();
+            DirectoryListing::Read( directory, listing );
+            DirectoryListing::AppendHtml( listing, 0, listing.Count(), out );
+            Keep( out.length() );
+        }
+    } ) );
+
+    a_results.push_back( Measure( "listing.cached_2000", [ & ]( uint64_t a_count )
+    {
+        DirectoryListing cache;
+        shared_ptr< const DirectoryListing::Listing > listing;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            Keep( cache.Get( directory, listing ) );
+        }
+    } ) );
+
+    for( uint32_t i = 0; i < files; ++i )
+    {
+        snprintf( name, sizeof( name ), "/report %04u & notes.txt", i );
+        unlink( ( directory + name ).c_str() );
+    }
+    rmdir( directory.c_str() );
+}
+
+static void BenchLock( vector< Result > &a_results )
+{
+    Counter counter;
+
+    a_results.push_back( Measure( "lock.uncontended", [ & ]( uint64_t a_count )
+    {
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            Lock lock( &counter );
+            ++counter.value;
+        }
+    } ) );
+
+    a_results.push_back( Measure( "lock.recursive", [ & ]( uint64_t a_count )
+    {
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            Lock outer( &counter );
+            Lock inner( &counter );
+            ++counter.value;
+        }
+    } ) );
+
+    SharedCounter shared;
+    a_results.push_back( Measure( "lock.shared", [ & ]( uint64_t a_count )
+    {
+        uint64_t sum = 0;
+        for( uint64_t i = 0; i < a_count; ++i )
+        {
+            SharedLock lock( &shared );
+            sum += shared.value;
+        }
+        Keep( sum );
+    } ) );
+
+    // Contended cost is reported per acquisition across all threads
+    uint32_t threads = max( 2U, thread::hardware_concurrency() );
+    a_results.push_back( Measure( "lock.contended", [ & ]( uint64_t a_count )
+    {
+        vector< thread > workers;
+        uint64_t share = ( a_count + threads - 1 ) / threads;
+        for( uint32_t t = 0; t < threads; ++t )
+        {
+            workers.emplace_back( [ & ]()
+            {
+                for( uint64_t i = 0; i < share; ++i )
+                {
+                    Lock lock( &counter );
+                    ++counter.value;
+                }
+            } );
+        }
+        for( auto &worker : workers )
+        {
+            worker.join();
+        }
+    } ) );
+
+    Keep( counter.value );
+}
+
+static void PrintJson( const vector< Result > &a_results )
+{
+    printf( "{\n" );
+    printf( "  \"version\": 1,\n" );
+    printf( "  \"unit\": \"ns/op\",\n" );
+    printf( "  \"benchmarks\": [\n" );
+    for( size_t i = 0; i < a_results.size(); ++i )
+    {
+        printf( "    { \"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f, \"min_ns_per_op\": %.2f }%s\n",
+            a_results[ i ].name.c_str(),
+            static_cast< unsigned long long >( a_results[ i ].iterations ),
+            a_results[ i ].nsPerOp,
+            a_results[ i ].minNsPerOp,
+            ( ( i + 1 ) < a_results.size() )? ",": "" );
+    }
+    printf( "  ]\n" );
+    printf( "}\n" );
+}
+
+int main( int argc, char *argv[] )
+{
+    // Optional filter: only run benchmarks whose group matches argv[1]
+    string filter = ( argc >= 2 )? argv[ 1 ]: "";
+    vector< Result > results;
+
+    struct Group
+    {
+        const char *name;
+        void      ( *function )( vector< Result > & );
+    };
+    const Group groups[] =
+    {
+        { "buffer",       BenchBuffer       },
+        { "tokens",       BenchTokens       },
+        { "staque",       BenchStaque       },
+        { "queue",        BenchQueue        },
+        { "scheduler",    BenchScheduler    },
+        { "timerwheel",   BenchTimerWheel   },
+        { "ratelimiter",  BenchRateLimiter  },
+        { "keyvaluepair", BenchKeyValuePair },
+        { "inifile",      BenchIniFile      },
+        { "httphelpers",  BenchHttpHelpers  },
+        { "sha1",         BenchSha1         },
+        { "base64",       BenchBase64       },
+        { "httpaccess",   BenchHttpAccess   },
+        { "listing",      BenchListing      },
+        { "lock",         BenchLock         },
+    };
+
+    for( const auto &group : groups )
+    {
+        if( ( filter.length() == 0 ) || ( filter == group.name ) )
+        {
+            group.function( results );
+        }
+    }
+
+    PrintJson( results );
+    return 0;
+}
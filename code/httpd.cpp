@@ -12,28 +12,129 @@
 #include <utils/KeyValuePair.hpp>
 #include <utils/HttpRequest.hpp>
 #include <utils/HttpAccess.hpp>
+#include <utils/DirectoryListing.hpp>
+#include <utils/RateLimiter.hpp>
+#include <utils/TimerWheel.hpp>
+#include <utils/LockProfiler.hpp>
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <stop_token>
+#include <vector>
+#include <errno.h>
+#include <signal.h>
 #include <unistd.h>
 #include <stdio.h>
 
 #define NUMTHREADS 64
+#define SHUTDOWNTO 30     // Default seconds to drain clients on SIGTERM
+#define SHUTDOWNKG 5      // Seconds allowed after interrupting stragglers
+#define REAPMS     100    // Milliseconds between checks for finished clients
 #define DEFMIME    "none" // Make sure this is defined in the ini file
 
 using namespace utils;
 using namespace std;
 
+// Request read deadlines from the [timeouts] section of the ini file; zero
+// keeps the HttpRequest default (or, for connection, sets no limit)
+struct RequestTimeouts
+{
+    uint32_t header     = 0;
+    uint32_t body       = 0;
+    uint32_t idle       = 0;
+    uint32_t connection = 0;
+
+    void Load( IniFile &a_settings );
+
+    void Apply( HttpRequest &a_request ) const
+    {
+        a_request.SetTimeouts( header, body, idle );
+    }
+};
+
 struct ThreadCTX : public Lockable
 {
-    shared_ptr< Socket     > socket;
-    shared_ptr< LogFile    > logger;
-    shared_ptr< IniFile    > settings;
-    shared_ptr< HttpAccess > access;
-    string                   address;
-    uint32_t                 port;
-    uint32_t                 id;
-    bool                     running;
+    shared_ptr< Socket      > socket;
+    shared_ptr< LogFile     > logger;
+    shared_ptr< IniFile     > settings;
+    shared_ptr< HttpAccess  > access;
+    shared_ptr< RateLimiter > limiter;
+    string                    address;
+    string                    peer; // Address counted by the rate limiter, if any
+    uint32_t                  port;
+    uint32_t                  id;
+    bool                      running;
+    stop_token                stop;
+    SocketOptions             socketOptions;
+    RequestTimeouts           timeouts;
+};
+
+// Thread attributes from the [threads] section of the ini file
+struct ThreadSettings
+{
+    size_t  stackSize = 0;
+    string  cpus;
+    int32_t numaNode  = -1;
+    int32_t policy    = SCHED_OTHER;
+    int32_t priority  = 0;
+    bool    schedule  = false;
+
+    void Load( IniFile &a_settings, const char *a_role );
+
+    template< typename type >
+    void Apply( Thread< type > &a_thread, const string &a_name ) const
+    {
+        if( stackSize > 0 )
+        {
+            a_thread.SetStackSize( stackSize );
+        }
+        if( cpus.length() > 0 )
+        {
+            a_thread.SetAffinity( cpus.c_str() );
+        }
+        else if( numaNode >= 0 )
+        {
+            a_thread.SetNumaNode( static_cast< uint32_t >( numaNode ) );
+        }
+        if( schedule )
+        {
+            a_thread.SetSchedule( policy, priority );
+        }
+        a_thread.SetName( a_name );
+    }
+};
+
+struct ListenerCTX : public Lockable
+{
+    shared_ptr< Socket      > listener;
+    shared_ptr< LogFile     > logger;
+    shared_ptr< IniFile     > settings;
+    shared_ptr< HttpAccess  > access;
+    shared_ptr< RateLimiter > limiter;
+    ThreadSettings            clientThreads;
+    SocketOptions             clientOptions;
+    RequestTimeouts           timeouts;
+    stop_token                server;
+    shared_ptr< atomic< bool > > abandoned; // Set when clients are left running at shutdown
+    uint32_t                  id;
+    uint32_t                  firstSlot;
+    uint32_t                  slots;
+    uint32_t                  drainSeconds;
+};
+
+struct SignalCTX : public Lockable
+{
+    shared_ptr< LogFile > logger;
+    stop_source           server;
+    stop_token            stop;
 };
 
+SocketOptions ReadSocketOptions( IniFile &a_settings, const char *a_role, bool a_shared );
+shared_ptr< RateLimiter > ReadLimits( IniFile &a_settings );
+int32_t RespondStatus( shared_ptr< Socket > &a_socket, int32_t a_status, const char *a_reason );
 void *ProcessClient( void *a_client );
+void *AcceptClients( void *a_listenerCtx );
+void *HandleSignals( void *a_signalCtx );
 void LogAuthResult( ThreadCTX *context, const HttpAccess::AuthResult &a_result );
 
 int main( int argc, char *argv[] )
@@ -41,6 +142,17 @@ int main( int argc, char *argv[] )
     UNUSED( argc );
     UNUSED( argv );
 
+    // Block SIGUSR1, SIGTERM, and SIGINT in every thread (the mask is
+    // inherited, so this comes before any thread starts, including the
+    // file watcher) and let a dedicated thread wait for them, so reports
+    // and shutdown are not driven from an asynchronous signal handler.
+    sigset_t signals;
+    sigemptyset( &signals );
+    sigaddset( &signals, SIGUSR1 );
+    sigaddset( &signals, SIGTERM );
+    sigaddset( &signals, SIGINT );
+    pthread_sigmask( SIG_BLOCK, &signals, nullptr );
+
     shared_ptr< LogFile > logger   = make_shared< LogFile >( "httpd.log" );
     shared_ptr< IniFile > settings = make_shared< IniFile >( "httpd.ini" );
 
@@ -75,59 +187,260 @@ int main( int argc, char *argv[] )
         return 0;
     }
 
-    // Start the listener
-    uint32_t flags = SocketFlags::TcpServer;
-    shared_ptr< Socket > listener =
-        make_shared< Socket >( address.c_str(), stoi( port ), flags );
-    if( !listener || !listener->Valid() )
+    ThreadSettings clientThreads;
+    ThreadSettings listenerThreads;
+    ThreadSettings signalThreads;
+    clientThreads.Load( *settings, "client" );
+    listenerThreads.Load( *settings, "listener" );
+    signalThreads.Load( *settings, "signal" );
+    RequestTimeouts timeouts;
+    timeouts.Load( *settings );
+    shared_ptr< RateLimiter > limiter = ReadLimits( *settings );
+
+    stop_source server;
+    Thread< SignalCTX > signalThread( HandleSignals );
+    signalThreads.Apply( signalThread, "httpd-signals" );
+    if( signalThread.GetContext() )
     {
-        printf( "Error listening on: %s:%s\n", address.c_str(), port.c_str() );
-        return 0;
+        signalThread.GetContext()->logger = logger;
+        signalThread.GetContext()->server = server;
+        signalThread.GetContext()->stop   = signalThread.GetStopToken();
+        signalThread.Start();
+    }
+
+    // Set by a listener that gives up on stuck clients at shutdown
+    shared_ptr< atomic< bool > > abandoned = make_shared< atomic< bool > >( false );
+
+    // Start the listeners. With more than one, each binds the same address
+    // with SO_REUSEPORT so the kernel spreads new connections across them.
+    string   value;
+    uint32_t listenerCount = 1;
+    if( settings->ReadValue( "settings", "listeners", value ) && Tokens::IsNumber( value ) && ( stol( value ) > 0 ) )
+    {
+        listenerCount = min< uint32_t >( static_cast< uint32_t >( stoul( value ) ), NUMTHREADS );
+    }
+    uint32_t drainSeconds = SHUTDOWNTO;
+    if( settings->ReadValue( "settings", "shutdown_timeout", value ) && Tokens::IsNumber( value ) && ( stol( value ) >= 0 ) )
+    {
+        drainSeconds = static_cast< uint32_t >( stoul( value ) );
     }
 
-    printf( "Listening for incoming connnections on: %s:%s\n",
-        address.c_str(), port.c_str() );
+    int32_t backlog = 100;
+    if( settings->ReadValue( "settings", "backlog", value ) && Tokens::IsNumber( value ) && ( stol( value ) > 0 ) )
+    {
+        backlog = stoi( value );
+    }
+
+    if( settings->ReadValue( "document", "listing_cache", value ) && Tokens::IsNumber( value ) )
+    {
+        DirectoryListing::Shared().SetCapacity( stoul( value ) );
+    }
+
+    uint32_t flags = SocketFlags::TcpServer | BIT( SocketFlags::NonBlocking );
+    if( listenerCount > 1 )
+    {
+        flags |= BIT( SocketFlags::ReusePort );
+    }
+    // Accepted sockets inherit the listener's options; client_ keys are
+    // applied again to each connection by its client thread.
+    SocketOptions listenerOptions = ReadSocketOptions( *settings, "listener", true );
+    SocketOptions clientOptions   = ReadSocketOptions( *settings, "client", false );
+
+    vector< shared_ptr< Socket > > listeners;
+    for( uint32_t l = 0; l < listenerCount; ++l )
+    {
+        shared_ptr< Socket > listener =
+            make_shared< Socket >( address.c_str(), stoi( port ), flags, backlog );
+        if( !listener || !listener->Valid() )
+        {
+            printf( "Error listening on: %s:%s\n", address.c_str(), port.c_str() );
+            return 0;
+        }
+        if( !listenerOptions.Apply( *listener ) )
+        {
+            printf( "Failed to apply some [socket] options (error: %d)\n", listener->LastError() );
+            logger->Log( "Failed to apply some [socket] options", true, true );
+        }
+        listeners.push_back( listener );
+    }
+
+    // A shutdown request wakes every accept loop
+    stop_callback interruptListeners( server.get_token(), [ &listeners ]()
+    {
+        for( auto &listener : listeners )
+        {
+            listener->Interrupt();
+        }
+    } );
+
+    printf( "Listening for incoming connnections on: %s:%s (%u listener(s))\n",
+        address.c_str(), port.c_str(), listenerCount );
     logger->Log( "Listening for incoming connections on: ", true, false );
     logger->Log( address, false, false );
     logger->Log( ":", false, false );
     logger->Log( port, false, true );
 
+    // Each listener gets its own accept thread and a share of the client slots
+    vector< shared_ptr< Thread< ListenerCTX > > > acceptors;
+    uint32_t share = NUMTHREADS / listenerCount;
+    for( uint32_t l = 0; l < listenerCount; ++l )
+    {
+        shared_ptr< Thread< ListenerCTX > > acceptor = make_shared< Thread< ListenerCTX > >( AcceptClients );
+        if( !acceptor || !( acceptor->GetContext() ) )
+        {
+            continue;
+        }
+        listenerThreads.Apply( *acceptor, "httpd-accept" + to_string( l ) );
+        acceptor->GetContext()->listener      = listeners[ l ];
+        acceptor->GetContext()->logger        = logger;
+        acceptor->GetContext()->settings      = settings;
+        acceptor->GetContext()->access        = access;
+        acceptor->GetContext()->limiter       = limiter;
+        acceptor->GetContext()->clientThreads = clientThreads;
+        acceptor->GetContext()->clientOptions = clientOptions;
+        acceptor->GetContext()->timeouts      = timeouts;
+        acceptor->GetContext()->server        = server.get_token();
+        acceptor->GetContext()->abandoned     = abandoned;
+        acceptor->GetContext()->id            = l;
+        acceptor->GetContext()->firstSlot     = l * share;
+        acceptor->GetContext()->slots         = ( ( l + 1 ) == listenerCount )? ( NUMTHREADS - ( l * share ) ): share;
+        acceptor->GetContext()->drainSeconds  = drainSeconds;
+        if( acceptor->Start() )
+        {
+            acceptors.push_back( acceptor );
+        }
+    }
+    if( acceptors.empty() )
+    {
+        printf( "Failed to start any listener threads\n" );
+        server.request_stop();
+    }
+    for( auto &acceptor : acceptors )
+    {
+        acceptor->Join();
+    }
+
+    // Wake the signal thread from sigwait so it sees the stop, and wait
+    // for it to exit
+    signalThread.RequestStop();
+    kill( getpid(), SIGUSR1 );
+    signalThread.Join();
+
+    if( abandoned->load() )
+    {
+        // Every listener has finished draining, but some client threads
+        // ignored their stop tokens; exit without running destructors
+        // they may still be using
+        printf( "Shutdown timed out; exiting\n" );
+        logger->Log( "Shutdown timed out; exiting", true, true );
+        fflush( stdout );
+        _exit( 1 );
+    }
+    printf( "Shutdown complete\n" );
+    logger->Log( "Shutdown complete", true, true );
+    return 0;
+}
+
+void *AcceptClients( void *a_listenerCtx )
+{
+    ListenerCTX *context = ( ListenerCTX * ) a_listenerCtx;
+    shared_ptr< Socket > &listener = context->listener;
+
     // Track the available threads
-    uint16_t availableThreads = NUMTHREADS;
-    shared_ptr< Thread< ThreadCTX > > clients[ NUMTHREADS ];
+    uint32_t availableThreads = context->slots;
+    vector< shared_ptr< Thread< ThreadCTX > > > clients( context->slots );
+
+    // Deadlines owned by this accept thread; the loop below ticks the wheel
+    // and sleeps until its next timer
+    TimerWheel timers( 10 );
+    vector< TimerWheel::TimerId > limits( context->slots, 0 );
 
-    while( listener->Valid() )
+    auto reapClients = [ & ]()
     {
-        string   address;
-        uint32_t port = 0;
-        shared_ptr< Socket > client = ( availableThreads > 0 )? listener->Accept( address, port ): nullptr;
+        // Iterate through the threads to free up any that have finished.
+        // Calling reset() will destruct the object and call ~Thread() which
+        // will call pthread_join().
+        for( uint32_t c = 0; c < context->slots; ++c )
+        {
+            if( clients[ c ] && !( clients[ c ]->GetContext()->running ) )
+            {
+                timers.Cancel( limits[ c ] );
+                limits[ c ] = 0;
+                clients[ c ].reset();
+                ++availableThreads;
+            }
+        }
+    };
 
-        if( client && client->Valid() && listener->Valid() )
+    while( listener->Valid() && !context->server.stop_requested() )
+    {
+        timers.Tick();
+        if( 0 == availableThreads )
         {
-            printf( "Client connected: %s:%u\n", address.c_str(), port );
-            for( uint32_t c = 0; ( c < NUMTHREADS ); ++c )
+            // No free threads; wait for one to finish or a timer to fire
+            usleep( timers.NextTimeout( REAPMS ) * 1000 );
+        }
+        else if( listener->WaitForRead( timers.NextTimeout( 1000 ) ) )
+        {
+            // Drain every pending connection while there are free slots; the
+            // peer address is formatted later by the client thread unless
+            // the rate limiter needs it now.
+            shared_ptr< Socket > client;
+            while( ( availableThreads > 0 ) && !context->server.stop_requested() &&
+                   ( client = listener->Accept() ) )
             {
-                if( !( clients[ c ] ) )
+                string   peer;
+                uint32_t peerPort = 0;
+                if( context->limiter && client->PeerAddress( peer, peerPort ) && !context->limiter->Connect( peer ) )
+                {
+                    // This client already holds its share of the threads
+                    int32_t response = RespondStatus( client, 503, "SERVICE UNAVAILABLE" );
+                    client->Shutdown();
+                    printf( "Connection limit reached (%s:%u)\n", peer.c_str(), peerPort );
+                    utils::Lock logLock( context->logger.get() );
+                    context->logger->Log( peer, true, false );
+                    context->logger->Log( ":", false, false );
+                    context->logger->Log( peerPort, false, false );
+                    context->logger->Log( " - Connection limit reached; response: ", false, false );
+                    context->logger->Log( response, false, true );
+                    continue;
+                }
+                for( uint32_t c = 0; ( c < context->slots ) && client; ++c )
                 {
-                    clients[ c ] = make_shared< Thread< ThreadCTX > >( ProcessClient );
-                    if( clients[ c ] && clients[ c ]->GetContext() )
+                    if( !( clients[ c ] ) )
                     {
-                        clients[ c ]->GetContext()->socket   = client;
-                        clients[ c ]->GetContext()->logger   = logger;
-                        clients[ c ]->GetContext()->settings = settings;
-                        clients[ c ]->GetContext()->access   = access;
-                        clients[ c ]->GetContext()->address  = address;
-                        clients[ c ]->GetContext()->port     = port;
-                        clients[ c ]->GetContext()->id       = c;
-                        clients[ c ]->GetContext()->running  = true;
-                        if( clients[ c ]->GetContext()->socket &&
-                            clients[ c ]->GetContext()->socket->Valid() )
+                        uint32_t id = context->firstSlot + c;
+                        clients[ c ] = make_shared< Thread< ThreadCTX > >( ProcessClient );
+                        if( clients[ c ] && clients[ c ]->GetContext() )
                         {
+                            context->clientThreads.Apply( *clients[ c ], "httpd-client" + to_string( id ) );
+                            clients[ c ]->GetContext()->socket   = client;
+                            clients[ c ]->GetContext()->logger   = context->logger;
+                            clients[ c ]->GetContext()->settings = context->settings;
+                            clients[ c ]->GetContext()->access   = context->access;
+                            clients[ c ]->GetContext()->limiter  = context->limiter;
+                            clients[ c ]->GetContext()->peer     = peer;
+                            clients[ c ]->GetContext()->port     = 0;
+                            clients[ c ]->GetContext()->id       = id;
+                            clients[ c ]->GetContext()->running  = true;
+                            clients[ c ]->GetContext()->stop     = clients[ c ]->GetStopToken();
+                            clients[ c ]->GetContext()->socketOptions = context->clientOptions;
+                            clients[ c ]->GetContext()->timeouts      = context->timeouts;
                             if( clients[ c ]->Start() )
                             {
                                 client = nullptr;
                                 --availableThreads;
-                                printf( "Client thread started (%s:%u)\n", address.c_str(), port );
+                                if( context->timeouts.connection > 0 )
+                                {
+                                    // Cut off connections that outlive the limit
+                                    limits[ c ] = timers.Schedule( context->timeouts.connection, [ &clients, c ]()
+                                    {
+                                        if( clients[ c ] )
+                                        {
+                                            clients[ c ]->RequestStop();
+                                        }
+                                    } );
+                                }
                             }
                             else
                             {
@@ -135,28 +448,296 @@ int main( int argc, char *argv[] )
                                 clients[ c ].reset();
                             }
                         }
-                        else
-                        {
-                            clients[ c ].reset();
-                        }
                     }
                 }
+                if( client && ( peer.length() > 0 ) )
+                {
+                    // No thread took it; release the count from Connect
+                    context->limiter->Disconnect( peer );
+                }
             }
-        } else { sleep(1); } // 1 second delay in case there are no free threads
+            if( ( availableThreads > 0 ) && !context->server.stop_requested() )
+            {
+                // Accept came back empty. Out of descriptors or memory, the
+                // connection stays queued and the listener stays readable,
+                // so wait for resources instead of polling again at once.
+                int32_t error = listener->LastError();
+                if( ( EMFILE == error ) || ( ENFILE == error ) || ( ENOBUFS == error ) || ( ENOMEM == error ) )
+                {
+                    usleep( timers.NextTimeout( REAPMS ) * 1000 );
+                }
+            }
+        }
 
-        // Iterate through the threads to free up any that have finished.
-        // Calling reset() will destruct the object and call ~Thread() which
-        // will call pthread_kill() and pthread_join().
-        for( uint32_t c = 0; c < NUMTHREADS; ++c )
+        reapClients();
+    }
+
+    // Stop accepting, then give in-flight requests until the deadline to
+    // finish before asking the stragglers to stop.
+    listener->Shutdown();
+    uint32_t busy = context->slots - availableThreads;
+    printf( "Listener %u shutting down; draining %u client(s)\n", context->id, busy );
+    {
+        utils::Lock logLock( context->logger.get() );
+        context->logger->Log( "Listener ", true, false );
+        context->logger->Log( context->id, false, false );
+        context->logger->Log( " shutting down; draining clients: ", false, false );
+        context->logger->Log( busy, false, true );
+    }
+
+    // Past the drain deadline, stop the stragglers through their stop
+    // tokens; if one is still stuck after that, give up on it and let main
+    // exit once every listener is done.
+    auto milliseconds = []( uint64_t a_seconds )
+    {
+        return static_cast< uint32_t >( min< uint64_t >( a_seconds * 1000, UINT32_MAX ) );
+    };
+    bool abandon = false;
+    timers.Schedule( milliseconds( context->drainSeconds ), [ & ]()
+    {
+        busy = context->slots - availableThreads;
+        printf( "Drain timed out; stopping %u client(s)\n", busy );
         {
-            if( clients[ c ] && !( clients[ c ]->GetContext()->running ) )
+            utils::Lock logLock( context->logger.get() );
+            context->logger->Log( "Drain timed out; stopping clients: ", true, false );
+            context->logger->Log( busy, false, true );
+        }
+        for( auto &client : clients )
+        {
+            if( client )
             {
-                clients[ c ].reset();
-                ++availableThreads;
+                client->RequestStop();
+            }
+        }
+        timers.Schedule( milliseconds( SHUTDOWNKG ), [ & ]()
+        {
+            busy = context->slots - availableThreads;
+            printf( "Listener %u abandoning %u client(s)\n", context->id, busy );
+            {
+                utils::Lock logLock( context->logger.get() );
+                context->logger->Log( "Listener ", true, false );
+                context->logger->Log( context->id, false, false );
+                context->logger->Log( " abandoning clients: ", false, false );
+                context->logger->Log( busy, false, true );
+            }
+            context->abandoned->store( true );
+            abandon = true;
+        } );
+    } );
+    while( ( availableThreads < context->slots ) && !abandon )
+    {
+        usleep( timers.NextTimeout( REAPMS ) * 1000 );
+        timers.Tick();
+        reapClients();
+    }
+    if( abandon )
+    {
+        // Joining a stuck thread would block forever; keep its wrapper
+        // alive instead, since main exits without destroying it
+        for( auto &client : clients )
+        {
+            if( client )
+            {
+                new shared_ptr< Thread< ThreadCTX > >( move( client ) );
+            }
+        }
+    }
+    pthread_exit( nullptr );
+}
+
+void RequestTimeouts::Load( IniFile &a_settings )
+{
+    auto read = [ & ]( const char *a_key, uint32_t &a_value )
+    {
+        string value;
+        if( a_settings.ReadValue( "timeouts", a_key, value ) && Tokens::IsNumber( value ) && ( stol( value ) > 0 ) )
+        {
+            a_value = static_cast< uint32_t >( stoul( value ) );
+        }
+    };
+    read( "header", header );
+    read( "body",   body );
+    read( "idle",   idle );
+    read( "connection", connection );
+}
+
+void ThreadSettings::Load( IniFile &a_settings, const char *a_role )
+{
+    // Role-specific keys (e.g. client_cpus) override the shared ones (cpus)
+    auto read = [ & ]( const char *a_key, string &a_value )
+    {
+        string key = string( a_role ) + "_" + a_key;
+        return a_settings.ReadValue( "threads", key.c_str(), a_value ) ||
+               a_settings.ReadValue( "threads", a_key, a_value );
+    };
+
+    string value;
+    if( read( "stack_size", value ) && Tokens::IsNumber( value ) && ( stol( value ) > 0 ) )
+    {
+        // Configured in KiB
+        stackSize = static_cast< size_t >( stoul( value ) ) * 1024;
+    }
+    read( "cpus", cpus );
+    if( read( "numa_node", value ) && Tokens::IsNumber( value ) )
+    {
+        numaNode = stoi( value );
+    }
+    if( read( "policy", value ) )
+    {
+        const struct
+        {
+            const char *name;
+            int32_t     policy;
+        } policies[] =
+        {
+            { "other", SCHED_OTHER },
+            { "batch", SCHED_BATCH },
+            { "idle",  SCHED_IDLE  },
+            { "fifo",  SCHED_FIFO  },
+            { "rr",    SCHED_RR    },
+        };
+        for( const auto &entry : policies )
+        {
+            if( value == entry.name )
+            {
+                policy   = entry.policy;
+                schedule = true;
             }
         }
     }
+    if( read( "priority", value ) && Tokens::IsNumber( value ) )
+    {
+        priority = stoi( value );
+    }
+}
+
+SocketOptions ReadSocketOptions( IniFile &a_settings, const char *a_role, bool a_shared )
+{
+    // Role-specific keys (e.g. listener_nodelay) override the shared ones
+    auto read = [ & ]( const char *a_key, string &a_value )
+    {
+        string key = string( a_role ) + "_" + a_key;
+        return a_settings.ReadValue( "socket", key.c_str(), a_value ) ||
+               ( a_shared && a_settings.ReadValue( "socket", a_key, a_value ) );
+    };
+    auto readNumber = [ & ]( const char *a_key, optional< uint32_t > &a_value )
+    {
+        string value;
+        if( read( a_key, value ) && Tokens::IsNumber( value ) && ( stol( value ) >= 0 ) )
+        {
+            a_value = static_cast< uint32_t >( stoul( value ) );
+        }
+    };
+    auto readFlag = [ & ]( const char *a_key, optional< bool > &a_value )
+    {
+        string value;
+        if( read( a_key, value ) )
+        {
+            Tokens::MakeLower( value );
+            a_value = ( value == "1" ) || ( value == "on" ) || ( value == "yes" ) || ( value == "true" );
+        }
+    };
+
+    SocketOptions options;
+    optional< uint32_t > number;
+    readFlag( "nodelay", options.noDelay );
+    readNumber( "defer_accept", options.deferAccept );
+    readNumber( "fastopen", options.fastOpen );
+    readNumber( "sndbuf", options.sendBuffer );
+    readNumber( "rcvbuf", options.receiveBuffer );
+    readNumber( "notsent_lowat", options.notSentLowat );
+    readFlag( "keepalive", options.keepAlive );
+    readNumber( "keepalive_idle", number );
+    options.keepIdle = number.value_or( 0 );
+    number.reset();
+    readNumber( "keepalive_interval", number );
+    options.keepInterval = number.value_or( 0 );
+    number.reset();
+    readNumber( "keepalive_count", number );
+    options.keepCount = number.value_or( 0 );
+    return options;
+}
+
+shared_ptr< RateLimiter > ReadLimits( IniFile &a_settings )
+{
+    auto read = [ & ]( const char *a_key )
+    {
+        string value;
+        if( a_settings.ReadValue( "limits", a_key, value ) && Tokens::IsNumber( value ) && ( stol( value ) > 0 ) )
+        {
+            return static_cast< uint32_t >( stoul( value ) );
+        }
+        return 0U;
+    };
+    uint32_t rate        = read( "requests_per_second" );
+    uint32_t burst       = read( "burst" );
+    uint32_t connections = read( "connections_per_client" );
+    uint32_t clients     = read( "clients" );
+    if( ( 0 == rate ) && ( 0 == connections ) )
+    {
+        return nullptr;
+    }
+    return make_shared< RateLimiter >( rate, ( burst > 0 )? burst: rate, connections, ( clients > 0 )? clients: 4096 );
+}
 
+int32_t RespondStatus( shared_ptr< Socket > &a_socket, int32_t a_status, const char *a_reason )
+{
+    if( !a_socket || !( a_socket->Valid() ) )
+    {
+        return -1;
+    }
+    string response = "HTTP/1.1 " + to_string( a_status ) + " " + a_reason + "\r\n"
+                      "Retry-After: 1\r\n"
+                      "Connection: Close\r\n"
+                      "Content-Length: 0\r\n\r\n";
+    uint32_t sent = 0;
+    while( ( sent < response.length() ) && a_socket->Valid() )
+    {
+        sent += a_socket->Write( reinterpret_cast< const uint8_t * >( response.data() ) + sent,
+                                 static_cast< uint32_t >( response.length() - sent ) );
+    }
+    return ( sent == response.length() )? a_status: -1;
+}
+
+void *HandleSignals( void *a_signalCtx )
+{
+    SignalCTX *context = ( SignalCTX * ) a_signalCtx;
+    sigset_t signals;
+    sigemptyset( &signals );
+    sigaddset( &signals, SIGUSR1 );
+    sigaddset( &signals, SIGTERM );
+    sigaddset( &signals, SIGINT );
+
+    int signal = 0;
+    while( context && !context->stop.stop_requested() && ( 0 == sigwait( &signals, &signal ) ) )
+    {
+        if( context->stop.stop_requested() )
+        {
+            break;
+        }
+        if( ( SIGTERM == signal ) || ( SIGINT == signal ) )
+        {
+            printf( "Received %s; shutting down\n", ( SIGTERM == signal )? "SIGTERM": "SIGINT" );
+            if( context->logger )
+            {
+                utils::Lock logLock( context->logger.get() );
+                context->logger->Log( ( SIGTERM == signal )? "Received SIGTERM; shutting down": "Received SIGINT; shutting down", true, true );
+            }
+            context->server.request_stop();
+        }
+        else if( SIGUSR1 == signal )
+        {
+            string report;
+            LockProfiler::Report( report );
+            printf( "%s", report.c_str() );
+            if( context->logger )
+            {
+                utils::Lock logLock( context->logger.get() );
+                context->logger->Log( "Lock profile:", true, true );
+                context->logger->Log( report, false, false );
+            }
+        }
+    }
     pthread_exit( nullptr );
 }
 
@@ -166,15 +747,28 @@ void *ProcessClient( void *a_clientCtx )
     shared_ptr< HttpRequest > httpRequest = make_shared< HttpRequest >();
     shared_ptr< utils::Lock > lock        = make_shared< Lock >( context );
 
+    // Give the connection back to the rate limiter before the socket closes
+    // so the client's next connection is not refused
+    auto release = [ context ]()
+    {
+        if( context->limiter && ( context->peer.length() > 0 ) )
+        {
+            context->limiter->Disconnect( context->peer );
+            context->peer.clear();
+        }
+    };
+
     if( ( nullptr == context       ) ||
        !( context->settings        ) ||
        !( context->logger          ) ||
        !( context->socket          ) ||
+       !( context->socket->PeerAddress( context->address, context->port ) ) ||
        !( context->socket->Valid() ) ||
         ( nullptr == httpRequest   ) )
     {
         if( nullptr != context )
         {
+            release();
             context->running = false;
         }
         printf( "Client processing failed\n" );
@@ -189,9 +783,48 @@ void *ProcessClient( void *a_clientCtx )
         context->logger->Log( " - Connected", false, true );
     }
 
-    printf( "Processing client (id: %u)\n", context->id );
+    if( !( context->socketOptions.Empty() ) )
+    {
+        context->socketOptions.Apply( *( context->socket ) );
+    }
 
-    if( context->socket->Valid() && httpRequest->Read( context->socket ) )
+    // Stopping this thread shuts the connection down so blocked reads and
+    // writes return and the request unwinds normally.
+    stop_callback interrupt( context->stop, [ context ]()
+    {
+        context->socket->Interrupt();
+    } );
+
+    printf( "Processing client %s:%u (id: %u)\n", context->address.c_str(), context->port, context->id );
+
+    context->timeouts.Apply( *httpRequest );
+    bool received = context->socket->Valid() && httpRequest->Read( context->socket );
+    if( !received && httpRequest->TimedOut() )
+    {
+        // Slow or silent client; tell it why the connection is closing
+        string  none;
+        int32_t response = httpRequest->Respond( context->socket, none, none );
+        printf( "Request timed out (%s:%u)\n", context->address.c_str(), context->port );
+        utils::Lock logLock( context->logger.get() );
+        context->logger->Log( context->address, true, false );
+        context->logger->Log( ":", false, false );
+        context->logger->Log( context->port, false, false );
+        context->logger->Log( " - Request timed out; response: ", false, false );
+        context->logger->Log( response, false, true );
+    }
+    else if( received && context->limiter && !context->limiter->Request( context->address ) )
+    {
+        // Over the per-client request rate
+        int32_t response = RespondStatus( context->socket, 429, "TOO MANY REQUESTS" );
+        printf( "Request rate limited (%s:%u)\n", context->address.c_str(), context->port );
+        utils::Lock logLock( context->logger.get() );
+        context->logger->Log( context->address, true, false );
+        context->logger->Log( ":", false, false );
+        context->logger->Log( context->port, false, false );
+        context->logger->Log( " - Request rate limited; response: ", false, false );
+        context->logger->Log( response, false, true );
+    }
+    else if( received )
     {
         httpRequest->RemoteAddress() = context->address;
         httpRequest->RemotePort()    = context->port;
@@ -216,7 +849,7 @@ void *ProcessClient( void *a_clientCtx )
             {
                 bListDirs = true;
             }
-            fileName = httpRequest->Uri();
+            fileName = httpRequest->Path();
             mimeType = DEFMIME;
             // Decode the URI and lookup the matching mime-type or use the default
             if( !HttpHelpers::UriDecode( hostHome, defaultDoc, fileName, fileType, mimeType ) ||
@@ -235,9 +868,8 @@ void *ProcessClient( void *a_clientCtx )
         bool authorized = true;
         if( context->access && context->access->Enabled() )
         {
-            authorized = context->access->IsAuthorized( *httpRequest, fileName );
             HttpAccess::AuthResult authResult;
-            context->access->GetLastResult( authResult );
+            authorized = context->access->IsAuthorized( *httpRequest, fileName, authResult );
             LogAuthResult( context, authResult );
             if( !authorized )
             {
@@ -285,10 +917,15 @@ void *ProcessClient( void *a_clientCtx )
                         // Reuse mime type: "text/plain"
                         httpRequest->Response() += context->address;
                     }
+                    else if( "locks" == operation )
+                    {
+                        // Reuse mime type: "text/plain"
+                        LockProfiler::Report( httpRequest->Response() );
+                    }
                     else if( "request" == operation )
                     {
                         mimeType = "text/html";
-                        shared_ptr< KeyValuePair< string, string > > meta = httpRequest->Meta();
+                        shared_ptr< HttpRequest::Header > meta = httpRequest->Meta();
                         httpRequest->Response() += "<!DOCTYPE html>\n<html>\n <head>\n  <title>Client Request</title>\n </head>\n<body>";
                         httpRequest->Response() += "Client: ";
                         httpRequest->Response() += context->address;
@@ -350,6 +987,7 @@ void *ProcessClient( void *a_clientCtx )
     }
 
     printf( "Finished processing client (%s:%u)\n", context->address.c_str(), context->port );
+    release();
     context->socket->Shutdown();
     printf( "Thread exiting (id: %u)\n", context->id );
     context->running = false;
@@ -0,0 +1,140 @@
+/**
+    Base64.cpp : Base64 implementation
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#include <utils/Base64.hpp>
+#include <array>
+
+#define BASE64_SKIP    0x40 // Whitespace
+#define BASE64_END     0x41 // Padding; the data ends here
+#define BASE64_INVALID 0x80
+
+namespace utils
+{
+    static const char s_encode[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    static constexpr ::std::array< uint8_t, 256 > MakeDecodeTable()
+    {
+        ::std::array< uint8_t, 256 > table{};
+        for( auto &value : table )
+        {
+            value = BASE64_INVALID;
+        }
+        for( uint8_t i = 0; i < 64; ++i )
+        {
+            table[ static_cast< uint8_t >( s_encode[ i ] ) ] = i;
+        }
+        // The same characters as Tokens::IsSpace
+        for( uint8_t c : { ' ', '\t', '\n', '\v', '\f', '\r' } )
+        {
+            table[ c ] = BASE64_SKIP;
+        }
+        table[ static_cast< uint8_t >( '=' ) ] = BASE64_END;
+        return table;
+    }
+
+    static constexpr ::std::array< uint8_t, 256 > s_decode = MakeDecodeTable();
+
+    size_t Base64::EncodedLength( size_t a_len )
+    {
+        return ( ( a_len + 2 ) / 3 ) * 4;
+    }
+
+    size_t Base64::DecodedLength( size_t a_len )
+    {
+        return ( ( a_len + 3 ) / 4 ) * 3;
+    }
+
+    void Base64::Encode( const uint8_t *a_data, size_t a_len, ::std::string &a_output )
+    {
+        size_t start = a_output.length();
+        a_output.resize( start + EncodedLength( a_len ) );
+        char  *out = a_output.data() + start;
+        size_t i   = 0;
+        for( ; ( i + 3 ) <= a_len; i += 3 )
+        {
+            uint32_t triple = ( static_cast< uint32_t >( a_data[ i ] ) << 16 ) |
+                              ( static_cast< uint32_t >( a_data[ i + 1 ] ) << 8 ) |
+                              ( static_cast< uint32_t >( a_data[ i + 2 ] ) );
+            *out++ = s_encode[ ( triple >> 18 ) & 0x3F ];
+            *out++ = s_encode[ ( triple >> 12 ) & 0x3F ];
+            *out++ = s_encode[ ( triple >> 6 ) & 0x3F ];
+            *out++ = s_encode[ triple & 0x3F ];
+        }
+        if( i < a_len )
+        {
+            bool     two    = ( ( i + 1 ) < a_len );
+            uint32_t triple = ( static_cast< uint32_t >( a_data[ i ] ) << 16 ) |
+                              ( two? ( static_cast< uint32_t >( a_data[ i + 1 ] ) << 8 ): 0 );
+            *out++ = s_encode[ ( triple >> 18 ) & 0x3F ];
+            *out++ = s_encode[ ( triple >> 12 ) & 0x3F ];
+            *out++ = two? s_encode[ ( triple >> 6 ) & 0x3F ]: '=';
+            *out++ = '=';
+        }
+    }
+
+    bool Base64::Decode( const char *a_input, size_t a_len, uint8_t *a_output, size_t &a_outputLen )
+    {
+        const uint8_t *in  = reinterpret_cast< const uint8_t * >( a_input );
+        uint8_t       *out = a_output;
+        size_t         i   = 0;
+
+        // Whole groups of four data characters; anything else (whitespace,
+        // padding, or an error) drops to the general loop below
+        for( ; ( i + 4 ) <= a_len; i += 4 )
+        {
+            uint8_t a = s_decode[ in[ i ] ];
+            uint8_t b = s_decode[ in[ i + 1 ] ];
+            uint8_t c = s_decode[ in[ i + 2 ] ];
+            uint8_t d = s_decode[ in[ i + 3 ] ];
+            if( 0 != ( ( a | b | c | d ) & 0xC0 ) )
+            {
+                break;
+            }
+            uint32_t triple = ( static_cast< uint32_t >( a ) << 18 ) | ( static_cast< uint32_t >( b ) << 12 ) |
+                              ( static_cast< uint32_t >( c ) << 6 ) | d;
+            *out++ = static_cast< uint8_t >( triple >> 16 );
+            *out++ = static_cast< uint8_t >( triple >> 8 );
+            *out++ = static_cast< uint8_t >( triple );
+        }
+
+        uint32_t value = 0;
+        int32_t  bits  = -8;
+        for( ; i < a_len; ++i )
+        {
+            uint8_t decoded = s_decode[ in[ i ] ];
+            if( decoded < 64 )
+            {
+                value = ( value << 6 ) | decoded;
+                bits += 6;
+                if( bits >= 0 )
+                {
+                    *out++ = static_cast< uint8_t >( value >> bits );
+                    bits -= 8;
+                }
+            }
+            else if( BASE64_END == decoded )
+            {
+                break;
+            }
+            else if( BASE64_SKIP != decoded )
+            {
+                a_outputLen = static_cast< size_t >( out - a_output );
+                return false;
+            }
+        }
+        a_outputLen = static_cast< size_t >( out - a_output );
+        return true;
+    }
+
+    bool Base64::Decode( const ::std::string &a_input, ::std::string &a_output )
+    {
+        a_output.resize( DecodedLength( a_input.length() ) );
+        size_t length = 0;
+        bool   valid  = Decode( a_input.data(), a_input.length(), reinterpret_cast< uint8_t * >( a_output.data() ), length );
+        a_output.resize( length );
+        return valid;
+    }
+}
@@ -44,9 +44,13 @@ namespace utils
 
     BitMask &BitMask::operator =( BitMask &a_bitMask )
     {
+        if( this == &a_bitMask )
+        {
+            return *this;
+        }
+        uint32_t value = static_cast< uint32_t >( a_bitMask );
         ::utils::Lock lock( this );
-        ::utils::Lock valueLock( &a_bitMask );
-        m_bitMask = static_cast< uint32_t >( a_bitMask );
+        m_bitMask = value;
         return *this;
     }
 
@@ -0,0 +1,284 @@
+/**
+    DirectoryListing.cpp : DirectoryListing implementation
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#include <utils/DirectoryListing.hpp>
+#include <utils/HttpHelpers.hpp>
+#include <utils/Lock.hpp>
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GETDENTSLEN  65536 // Bytes of entries read per getdents64 call
+#define ENTRYMARKUP  96    // Fixed markup around each rendered entry
+
+namespace utils
+{
+    DirectoryListing::DirectoryListing( size_t a_capacity /*= 16777216*/ )
+    : m_entries()
+    , m_order()
+    , m_bytes( 0 )
+    , m_capacity( a_capacity )
+    {
+    }
+
+    void DirectoryListing::SetCapacity( size_t a_capacity )
+    {
+        ::utils::Lock lock( this );
+        m_capacity = a_capacity;
+        Evict( 0 );
+    }
+
+    void DirectoryListing::Clear()
+    {
+        ::utils::Lock lock( this );
+        m_entries.clear();
+        m_order.clear();
+        m_bytes = 0;
+    }
+
+    void DirectoryListing::Evict( size_t a_bytes )
+    {
+        // Second chance: a listing read since it was last at the front goes
+        // to the back once, so each is passed over at most once per call
+        while( ( ( m_bytes + a_bytes ) > m_capacity ) && !m_order.empty() )
+        {
+            auto oldest = m_entries.find( m_order.front() );
+            if( oldest->second.used.exchange( false, ::std::memory_order_relaxed ) )
+            {
+                m_order.splice( m_order.end(), m_order, oldest->second.position );
+                continue;
+            }
+            m_bytes -= oldest->second.listing->Bytes();
+            m_order.pop_front();
+            m_entries.erase( oldest );
+        }
+    }
+
+    bool DirectoryListing::Get( const ::std::string &a_path, ::std::shared_ptr< const Listing > &a_listing )
+    {
+        struct stat st{};
+        if( ( 0 != stat( a_path.c_str(), &st ) ) || !S_ISDIR( st.st_mode ) )
+        {
+            return false;
+        }
+        int64_t modTime  = ( static_cast< int64_t >( st.st_mtim.tv_sec ) * 1000000000LL ) + st.st_mtim.tv_nsec;
+        size_t  capacity = 0;
+        {
+            ::utils::SharedLock lock( this );
+            capacity = m_capacity;
+            auto found = m_entries.find( a_path );
+            if( ( found != m_entries.end() ) && ( found->second.listing->modTime == modTime ) &&
+                ( found->second.listing->inode == static_cast< uint64_t >( st.st_ino ) ) )
+            {
+                found->second.used.store( true, ::std::memory_order_relaxed );
+                a_listing = found->second.listing;
+                return true;
+            }
+        }
+
+        // Read unlocked; another request for the same directory may do the
+        // same, and the last one to finish is kept
+        auto listing = ::std::make_shared< Listing >();
+        if( !listing || !Read( a_path, *listing ) )
+        {
+            return false;
+        }
+        size_t limit = capacity / 8;
+        if( ( listing->names.length() * 2 ) + ( listing->Count() * ENTRYMARKUP ) <= limit )
+        {
+            AppendHtml( *listing, 0, listing->Count(), listing->html );
+        }
+        a_listing = listing;
+
+        timespec now{};
+        clock_gettime( CLOCK_REALTIME, &now );
+        bool settled = ( listing->modTime / 1000000000LL ) < ( static_cast< int64_t >( now.tv_sec ) - 1 );
+        size_t bytes = listing->Bytes();
+        if( !settled || ( bytes > limit ) )
+        {
+            return true;
+        }
+        ::utils::Lock lock( this );
+        if( bytes > ( m_capacity / 8 ) )
+        {
+            // Shrunk while this was being read
+            return true;
+        }
+        auto found = m_entries.find( a_path );
+        if( found != m_entries.end() )
+        {
+            m_bytes -= found->second.listing->Bytes();
+            m_order.erase( found->second.position );
+            m_entries.erase( found );
+        }
+        Evict( bytes );
+        Entry &entry   = m_entries[ a_path ];
+        entry.listing  = listing;
+        entry.position = m_order.insert( m_order.end(), a_path );
+        m_bytes += bytes;
+        return true;
+    }
+
+    bool DirectoryListing::Read( const ::std::string &a_path, Listing &a_listing )
+    {
+        int32_t fd = open( a_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+        if( fd < 0 )
+        {
+            return false;
+        }
+        struct stat st{};
+        if( 0 != fstat( fd, &st ) )
+        {
+            close( fd );
+            return false;
+        }
+        a_listing.modTime = ( static_cast< int64_t >( st.st_mtim.tv_sec ) * 1000000000LL ) + st.st_mtim.tv_nsec;
+        a_listing.inode   = static_cast< uint64_t >( st.st_ino );
+        a_listing.names.clear();
+        a_listing.sorted.clear();
+        a_listing.html.clear();
+
+        // Many entries per system call, straight into one block of names
+        ::std::vector< uint64_t > buffer( GETDENTSLEN / sizeof( uint64_t ) );
+        bool ok = true;
+        while( true )
+        {
+            ssize_t length = getdents64( fd, buffer.data(), GETDENTSLEN );
+            if( length <= 0 )
+            {
+                ok = ( 0 == length );
+                break;
+            }
+            const char *base = reinterpret_cast< const char * >( buffer.data() );
+            for( ssize_t offset = 0; offset < length; )
+            {
+                const dirent64 *entry = reinterpret_cast< const dirent64 * >( base + offset );
+                offset += entry->d_reclen;
+                // Skip ., .., and hidden files
+                if( entry->d_name[ 0 ] == '.' )
+                {
+                    continue;
+                }
+                uint8_t type = entry->d_type;
+                if( DT_UNKNOWN == type )
+                {
+                    // Not every filesystem reports types
+                    struct stat entryStat{};
+                    if( 0 != fstatat( fd, entry->d_name, &entryStat, AT_SYMLINK_NOFOLLOW ) )
+                    {
+                        continue;
+                    }
+                    type = S_ISLNK( entryStat.st_mode )? DT_LNK: ( S_ISDIR( entryStat.st_mode )? DT_DIR: DT_REG );
+                }
+                // Skip symlinks
+                if( DT_LNK == type )
+                {
+                    continue;
+                }
+                Listing::Name name{ static_cast< uint32_t >( a_listing.names.length() ),
+                                    static_cast< uint32_t >( strlen( entry->d_name ) ) };
+                a_listing.names.append( entry->d_name, name.length );
+                if( DT_DIR == type )
+                {
+                    a_listing.names += '/';
+                    ++name.length;
+                }
+                a_listing.sorted.push_back( name );
+            }
+        }
+        close( fd );
+        if( !ok )
+        {
+            return false;
+        }
+
+        const char *names = a_listing.names.data();
+        ::std::sort( a_listing.sorted.begin(), a_listing.sorted.end(), [ names ]( const Listing::Name &a_left, const Listing::Name &a_right )
+        {
+            return ::std::string_view( names + a_left.offset, a_left.length ) <
+                   ::std::string_view( names + a_right.offset, a_right.length );
+        } );
+        return true;
+    }
+
+    void DirectoryListing::AppendHtml( const Listing &a_listing, size_t a_first, size_t a_count, ::std::string &a_output )
+    {
+        size_t last = ::std::min( a_listing.Count(), a_first + ::std::min( a_count, a_listing.Count() ) );
+        for( size_t i = a_first; i < last; ++i )
+        {
+            ::std::string_view name = a_listing.Entry( i );
+            // For no style, use:
+            //a_output += "<a style=\"font-family: monospace;\" href=\"";
+            a_output += "<div class=\"entry\">\n"
+                        "<a class=\"entry-link\" href=\"";
+            if( name.back() == '/' )
+            {
+                // URL encoding the trailing slash is ugly and breaks things
+                HttpHelpers::UriEncode( name.data(), name.length() - 1, a_output );
+                // The slash is needed for relative links, however
+                a_output += '/';
+            }
+            else
+            {
+                HttpHelpers::UriEncode( name.data(), name.length(), a_output );
+            }
+            a_output += "\">";
+            // For no style, remove this line:
+            a_output += "<span class=\"bullet\">• </span>";
+            HttpHelpers::HtmlEscape( name.data(), name.length(), a_output );
+            // For no style, use:
+            //a_output += "</a><br>\n";
+            a_output += "</a></div>\n";
+        }
+    }
+
+    void DirectoryListing::AppendJson( const Listing &a_listing, const ::std::string &a_path, size_t a_first, size_t a_count,
+                                       bool &a_started, ::std::string &a_output )
+    {
+        size_t last = ::std::min( a_listing.Count(), a_first + ::std::min( a_count, a_listing.Count() ) );
+        if( a_first >= last )
+        {
+            return;
+        }
+        int32_t fd = open( a_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+        if( fd < 0 )
+        {
+            return;
+        }
+        ::std::string name;
+        char          numbers[ 64 ];
+        for( size_t i = a_first; i < last; ++i )
+        {
+            ::std::string_view entry     = a_listing.Entry( i );
+            bool               directory = ( entry.back() == '/' );
+            name.assign( entry.data(), entry.length() - ( directory? 1: 0 ) );
+            struct stat st{};
+            if( 0 != fstatat( fd, name.c_str(), &st, AT_SYMLINK_NOFOLLOW ) )
+            {
+                continue;
+            }
+            a_output += a_started? ",\n{\"name\":\"": "\n{\"name\":\"";
+            a_started = true;
+            HttpHelpers::JsonEscape( name.data(), name.length(), a_output );
+            a_output += directory? "\",\"type\":\"directory\"": "\",\"type\":\"file\"";
+            snprintf( numbers, sizeof( numbers ), ",\"size\":%lld,\"mtime\":%lld}",
+                      static_cast< long long >( st.st_size ), static_cast< long long >( st.st_mtim.tv_sec ) );
+            a_output += numbers;
+        }
+        close( fd );
+    }
+
+    DirectoryListing &DirectoryListing::Shared()
+    {
+        static DirectoryListing s_shared;
+        return s_shared;
+    }
+}
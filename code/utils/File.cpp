@@ -5,6 +5,7 @@
 */
 
 #include <utils/File.hpp>
+#include <utils/FileWatcher.hpp>
 #include <cstring>
 #include <stdio.h>
 #include <sys/stat.h>
@@ -19,6 +20,8 @@ namespace utils
     , m_lastModTime( 0 )
     , m_lastModTimeValid( false )
     , m_modifiedLocally( false )
+    , m_watch( 0 )
+    , m_statStale( false )
     , m_file( a_file )
     , m_ready( false )
     {
@@ -40,6 +43,8 @@ namespace utils
     , m_lastModTime( 0 )
     , m_lastModTimeValid( false )
     , m_modifiedLocally( false )
+    , m_watch( 0 )
+    , m_statStale( false )
     , m_file( nullptr )
     , m_ready( false )
     {
@@ -54,6 +59,11 @@ namespace utils
 
     File::~File()
     {
+        if( 0 != m_watch )
+        {
+            // Waits out a running callback, so it must not hold the lock
+            FileWatcher::Shared().Unwatch( m_watch );
+        }
         ::utils::Lock lock( this );
         Close();
     }
@@ -193,6 +203,26 @@ namespace utils
         return 0;
     }
 
+    bool File::Watch()
+    {
+        ::utils::Lock lock( this );
+        if( 0 != m_watch )
+        {
+            return true;
+        }
+        if( m_fileName.empty() )
+        {
+            return false;
+        }
+        m_watch = FileWatcher::Shared().Watch( m_fileName, [ this ]( const ::std::string & )
+        {
+            m_statStale.store( true );
+        } );
+        // Anything cached so far predates the watch
+        m_statStale.store( true );
+        return ( 0 != m_watch );
+    }
+
     bool File::Seek( int64_t a_position )
     {
         ::utils::Lock lock( this );
@@ -476,11 +506,13 @@ namespace utils
 
     bool File::RefreshStatCache( bool a_forceRefresh /*= false*/ )
     {
-        if( !a_forceRefresh && m_cachedStatValid )
+        if( m_cachedStatValid && ( !a_forceRefresh || ( ( 0 != m_watch ) && !m_statStale.load() ) ) )
         {
             return m_cachedPathExists;
         }
 
+        // Cleared before the stat so a change during it is not lost
+        m_statStale.store( false );
         InvalidateStatCache();
         struct stat fileStat{};
         bool ok = false;
@@ -0,0 +1,402 @@
+/**
+    FileWatcher.cpp : FileWatcher implementation
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#include <utils/FileWatcher.hpp>
+#include <utils/Lock.hpp>
+#include <utils/Thread.hpp>
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Directory events that can mean a file in it changed
+#define FILEWATCHER_EVENTS ( IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_ATTRIB )
+
+namespace utils
+{
+    struct FileWatcherCTX
+    {
+        FileWatcher *watcher = nullptr;
+    };
+
+    FileWatcher::FileWatcher( uint32_t a_pollMs /*= 1000*/, uint32_t a_debounceMs /*= 50*/ )
+    : m_files()
+    , m_ids()
+    , m_directories()
+    , m_nextId( 0 )
+    , m_delivering( 0 )
+    , m_threadId()
+    , m_inotify( inotify_init1( IN_NONBLOCK | IN_CLOEXEC ) )
+    , m_wake( eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) )
+    , m_pollMs( ( 0 == a_pollMs )? 1: a_pollMs )
+    , m_debounceMs( a_debounceMs )
+    , m_stopping( false )
+    , m_thread()
+    {
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        {
+            ::utils::Lock lock( this );
+            m_stopping = true;
+            Wake();
+        }
+        if( m_thread )
+        {
+            m_thread->Join();
+        }
+        if( m_inotify >= 0 )
+        {
+            close( m_inotify );
+        }
+        if( m_wake >= 0 )
+        {
+            close( m_wake );
+        }
+    }
+
+    void FileWatcher::Wake()
+    {
+        if( m_wake >= 0 )
+        {
+            uint64_t one = 1;
+            ssize_t  written = write( m_wake, &one, sizeof( one ) );
+            UNUSED( written );
+        }
+    }
+
+    void FileWatcher::AddDescriptor( WatchedFile &a_file )
+    {
+        if( ( m_inotify < 0 ) || ( a_file.descriptor >= 0 ) )
+        {
+            return;
+        }
+        int32_t descriptor = inotify_add_watch( m_inotify, a_file.directory.c_str(), FILEWATCHER_EVENTS );
+        if( descriptor >= 0 )
+        {
+            a_file.descriptor = descriptor;
+            ++m_directories[ descriptor ];
+        }
+    }
+
+    void FileWatcher::RemoveDescriptor( int32_t a_descriptor )
+    {
+        auto found = m_directories.find( a_descriptor );
+        if( found == m_directories.end() )
+        {
+            return;
+        }
+        if( 0 == --( found->second ) )
+        {
+            inotify_rm_watch( m_inotify, a_descriptor );
+            m_directories.erase( found );
+        }
+    }
+
+    bool FileWatcher::Snapshot( WatchedFile &a_file )
+    {
+        struct stat st{};
+        bool    exists  = ( 0 == stat( a_file.path.c_str(), &st ) );
+        int64_t modTime = exists? ( ( static_cast< int64_t >( st.st_mtim.tv_sec ) * 1000000000LL ) + st.st_mtim.tv_nsec ): 0;
+        int64_t size    = exists? static_cast< int64_t >( st.st_size ): 0;
+        uint64_t inode  = exists? static_cast< uint64_t >( st.st_ino ): 0;
+        bool changed = ( exists != a_file.exists ) || ( modTime != a_file.modTime ) ||
+                       ( size != a_file.size ) || ( inode != a_file.inode );
+        a_file.exists  = exists;
+        a_file.modTime = modTime;
+        a_file.size    = size;
+        a_file.inode   = inode;
+        return changed;
+    }
+
+    void FileWatcher::Mark( WatchedFile &a_file, Time a_now )
+    {
+        // Each event pushes the check back, but a file that never goes
+        // quiet is still checked every few intervals
+        auto debounce = ::std::chrono::milliseconds( m_debounceMs );
+        if( !a_file.pending )
+        {
+            a_file.pending = true;
+            a_file.since   = a_now;
+        }
+        a_file.due = ::std::min( a_now + debounce, a_file.since + ( debounce * 4 ) );
+    }
+
+    void FileWatcher::ReadEvents()
+    {
+        alignas( inotify_event ) char buffer[ 4096 ];
+        auto now = ::std::chrono::steady_clock::now();
+        while( true )
+        {
+            ssize_t length = read( m_inotify, buffer, sizeof( buffer ) );
+            if( length <= 0 )
+            {
+                break;
+            }
+            for( ssize_t offset = 0; offset < length; )
+            {
+                const inotify_event *event = reinterpret_cast< const inotify_event * >( buffer + offset );
+                offset += static_cast< ssize_t >( sizeof( inotify_event ) + event->len );
+                if( 0 != ( event->mask & IN_Q_OVERFLOW ) )
+                {
+                    // Events were lost; check everything
+                    for( auto &file : m_files )
+                    {
+                        Mark( file.second, now );
+                    }
+                    continue;
+                }
+                if( 0 != ( event->mask & IN_IGNORED ) )
+                {
+                    // The directory went away; poll its files until it is back
+                    m_directories.erase( event->wd );
+                    for( auto &file : m_files )
+                    {
+                        if( file.second.descriptor == event->wd )
+                        {
+                            file.second.descriptor = -1;
+                            Mark( file.second, now );
+                        }
+                    }
+                    continue;
+                }
+                if( 0 == event->len )
+                {
+                    continue;
+                }
+                for( auto &file : m_files )
+                {
+                    if( ( file.second.descriptor == event->wd ) && ( file.second.name == event->name ) )
+                    {
+                        Mark( file.second, now );
+                    }
+                }
+            }
+        }
+    }
+
+    bool FileWatcher::Collect( bool a_poll, Time a_now, Time &a_next, ::std::vector< Delivery > &a_due )
+    {
+        bool polled = false;
+        for( auto &entry : m_files )
+        {
+            WatchedFile &file  = entry.second;
+            bool         check = false;
+            if( a_poll && ( file.descriptor < 0 ) )
+            {
+                AddDescriptor( file );
+                check = true;
+            }
+            if( file.pending )
+            {
+                if( file.due <= a_now )
+                {
+                    file.pending = false;
+                    check        = true;
+                }
+                else
+                {
+                    a_next = ::std::min( a_next, file.due );
+                }
+            }
+            if( check && Snapshot( file ) )
+            {
+                for( const auto &callback : file.callbacks )
+                {
+                    a_due.push_back( { callback.first, callback.second, file.path } );
+                }
+            }
+            polled = polled || ( file.descriptor < 0 );
+        }
+        return polled;
+    }
+
+    void *FileWatcher::Run( void *a_context )
+    {
+        FileWatcher &watcher = *( reinterpret_cast< FileWatcherCTX * >( a_context )->watcher );
+        auto nextPoll = ::std::chrono::steady_clock::now() + ::std::chrono::milliseconds( watcher.m_pollMs );
+        auto nextDue  = Time::max();
+        bool polled   = false;
+        {
+            ::utils::Lock lock( &watcher );
+            watcher.m_threadId = ::std::this_thread::get_id();
+            for( const auto &file : watcher.m_files )
+            {
+                polled = polled || ( file.second.descriptor < 0 );
+            }
+        }
+
+        while( true )
+        {
+            int32_t timeout = -1;
+            Time    wakeAt  = polled? ::std::min( nextPoll, nextDue ): nextDue;
+            if( wakeAt != Time::max() )
+            {
+                auto wait = ::std::chrono::ceil< ::std::chrono::milliseconds >( wakeAt - ::std::chrono::steady_clock::now() );
+                timeout = static_cast< int32_t >( ::std::max< int64_t >( 0, wait.count() ) );
+            }
+            pollfd fds[ 2 ] = { { watcher.m_wake, POLLIN, 0 }, { watcher.m_inotify, POLLIN, 0 } };
+            poll( fds, 2, timeout );
+
+            ::std::vector< Delivery > due;
+            {
+                ::utils::Lock lock( &watcher );
+                if( watcher.m_stopping )
+                {
+                    break;
+                }
+                if( 0 != ( fds[ 0 ].revents & POLLIN ) )
+                {
+                    uint64_t count = 0;
+                    ssize_t  got   = read( watcher.m_wake, &count, sizeof( count ) );
+                    UNUSED( got );
+                }
+                if( 0 != ( fds[ 1 ].revents & POLLIN ) )
+                {
+                    watcher.ReadEvents();
+                }
+                auto now  = ::std::chrono::steady_clock::now();
+                bool poll = ( now >= nextPoll );
+                if( poll )
+                {
+                    nextPoll = now + ::std::chrono::milliseconds( watcher.m_pollMs );
+                }
+                nextDue = Time::max();
+                polled  = watcher.Collect( poll, now, nextDue, due );
+            }
+
+            for( auto &change : due )
+            {
+                {
+                    // Skip watches removed since they were collected, and
+                    // let Unwatch see which callback is running
+                    ::utils::Lock lock( &watcher );
+                    if( watcher.m_ids.count( change.id ) == 0 )
+                    {
+                        continue;
+                    }
+                    watcher.m_delivering = change.id;
+                }
+                try
+                {
+                    change.callback( change.path );
+                }
+                catch( const ::std::exception &e )
+                {
+                    UNUSED( e );
+                }
+                catch( ... )
+                {
+                }
+                ::utils::Lock lock( &watcher );
+                watcher.m_delivering = 0;
+            }
+        }
+        return nullptr;
+    }
+
+    FileWatcher::WatchId FileWatcher::Watch( const ::std::string &a_path, Callback &&a_callback )
+    {
+        if( ( a_path.length() == 0 ) || !a_callback )
+        {
+            return 0;
+        }
+        ::utils::Lock lock( this );
+        if( m_stopping || ( m_wake < 0 ) )
+        {
+            return 0;
+        }
+        if( !m_thread )
+        {
+            m_thread = ::std::make_unique< Thread< FileWatcherCTX > >( Run );
+            m_thread->GetContext()->watcher = this;
+            m_thread->SetName( "filewatcher" );
+            if( !m_thread->Start() )
+            {
+                m_thread.reset();
+                return 0;
+            }
+        }
+
+        WatchId id = ++m_nextId;
+        auto found = m_files.find( a_path );
+        if( found == m_files.end() )
+        {
+            WatchedFile file;
+            auto  slash = a_path.find_last_of( '/' );
+            file.path      = a_path;
+            file.directory = ( slash == ::std::string::npos )? ".": ( ( 0 == slash )? "/": a_path.substr( 0, slash ) );
+            file.name      = ( slash == ::std::string::npos )? a_path: a_path.substr( slash + 1 );
+            AddDescriptor( file );
+            Snapshot( file );
+            found = m_files.emplace( a_path, ::std::move( file ) ).first;
+            // The thread may need to start polling
+            Wake();
+        }
+        found->second.callbacks.emplace( id, ::std::move( a_callback ) );
+        m_ids.emplace( id, a_path );
+        return id;
+    }
+
+    bool FileWatcher::Unwatch( WatchId a_id )
+    {
+        {
+            ::utils::Lock lock( this );
+            auto found = m_ids.find( a_id );
+            if( found == m_ids.end() )
+            {
+                return false;
+            }
+            auto file = m_files.find( found->second );
+            if( file != m_files.end() )
+            {
+                file->second.callbacks.erase( a_id );
+                if( file->second.callbacks.empty() )
+                {
+                    if( file->second.descriptor >= 0 )
+                    {
+                        RemoveDescriptor( file->second.descriptor );
+                    }
+                    m_files.erase( file );
+                }
+            }
+            m_ids.erase( found );
+            if( ( m_delivering != a_id ) || ( ::std::this_thread::get_id() == m_threadId ) )
+            {
+                return true;
+            }
+        }
+
+        // The callback is running on the watcher thread; let it return
+        while( true )
+        {
+            ::std::this_thread::sleep_for( ::std::chrono::milliseconds( 1 ) );
+            ::utils::Lock lock( this );
+            if( m_delivering != a_id )
+            {
+                return true;
+            }
+        }
+    }
+
+    bool FileWatcher::UsingInotify()
+    {
+        ::utils::Lock lock( this );
+        return ( m_inotify >= 0 );
+    }
+
+    FileWatcher &FileWatcher::Shared()
+    {
+        // Deliberately leaked; see the header
+        static FileWatcher *s_shared = new FileWatcher();
+        return *s_shared;
+    }
+}
@@ -6,16 +6,19 @@
 */
 
 #include <utils/HttpAccess.hpp>
+#include <utils/Base64.hpp>
 #include <utils/Buffer.hpp>
 #include <utils/File.hpp>
 #include <utils/HttpHelpers.hpp>
 #include <utils/HttpRequest.hpp>
 #include <utils/IniFile.hpp>
 #include <utils/Lock.hpp>
+#include <utils/Sha1.hpp>
 #include <utils/Socket.hpp>
 #include <utils/Tokens.hpp>
 #include <crypt.h>
 #include <string.h>
+#include <thread>
 #include <vector>
 
 #define MAXBUFFERLEN 4096
@@ -23,87 +26,205 @@
 namespace utils
 {
     HttpAccess::HttpAccess()
-    : m_enabled( false )
-    , m_loaded( false )
-    , m_accessLoaded( false )
+    : m_tables()
+    , m_fileWatch( 0 )
+    , m_enabled( false )
+    , m_generation( 0 )
     {
-        m_lastAuth.enabled = false;
-        m_lastAuth.authorized = true;
-        m_lastAuth.headerPresent = false;
-        m_lastAuth.schemeValid = false;
-        m_lastAuth.decoded = false;
-        m_lastAuth.credentialsValid = false;
-        m_lastAuth.user.clear();
-        m_lastAuth.reason = "access disabled";
+        m_lastAuth.result.enabled = false;
+        m_lastAuth.result.authorized = true;
+        m_lastAuth.result.headerPresent = false;
+        m_lastAuth.result.schemeValid = false;
+        m_lastAuth.result.decoded = false;
+        m_lastAuth.result.credentialsValid = false;
+        m_lastAuth.result.user.clear();
+        m_lastAuth.result.reason = "access disabled";
+    }
+
+    HttpAccess::~HttpAccess()
+    {
+        UnwatchAll();
+    }
+
+    void HttpAccess::UnwatchAll()
+    {
+        // Unwatch waits for a running callback, which may itself need the
+        // lock, so the ids are taken under the lock and released outside it
+        ::std::vector< FileWatcher::WatchId > watches;
+        {
+            utils::Lock lock( this );
+            if( 0 != m_fileWatch )
+            {
+                watches.push_back( m_fileWatch );
+                m_fileWatch = 0;
+            }
+            for( const auto &watch : m_accessWatches )
+            {
+                watches.push_back( watch.second );
+            }
+            m_accessWatches.clear();
+        }
+        for( auto watch : watches )
+        {
+            FileWatcher::Shared().Unwatch( watch );
+        }
     }
 
     bool HttpAccess::Configure( IniFile &a_ini )
     {
+        UnwatchAll();
         utils::Lock lock( this );
+        m_accessLists.clear();
+        m_tables.store( nullptr );
+        {
+            utils::Lock cacheLock( &m_accessCache );
+            m_accessCache.entries.clear();
+            m_accessCache.order.clear();
+            ++m_accessCache.generation;
+            m_accessCache.capacity = 4096;
+            m_accessCache.ttl      = 5;
+            ::std::string value;
+            if( a_ini.ReadValue( "settings", "access_cache", value ) && Tokens::IsNumber( value ) )
+            {
+                m_accessCache.capacity = static_cast< uint32_t >( ::std::stoul( value ) );
+            }
+            if( a_ini.ReadValue( "settings", "access_cache_ttl", value ) && Tokens::IsNumber( value ) )
+            {
+                m_accessCache.ttl = static_cast< uint32_t >( ::std::stoul( value ) );
+            }
+        }
+        {
+            utils::Lock cacheLock( &m_authCache );
+            m_authCache.entries.clear();
+            m_authCache.order.clear();
+            m_authCache.capacity = 1024;
+            m_authCache.ttl      = 300;
+            ::std::string value;
+            if( a_ini.ReadValue( "settings", "auth_cache", value ) && Tokens::IsNumber( value ) )
+            {
+                m_authCache.capacity = static_cast< uint32_t >( ::std::stoul( value ) );
+            }
+            if( a_ini.ReadValue( "settings", "auth_cache_ttl", value ) && Tokens::IsNumber( value ) )
+            {
+                m_authCache.ttl = static_cast< uint32_t >( ::std::stoul( value ) );
+            }
+        }
+        ::std::string concurrency;
+        ::std::ptrdiff_t verifiers = ::std::max( 1U, ::std::thread::hardware_concurrency() );
+        if( a_ini.ReadValue( "settings", "auth_concurrency", concurrency ) && Tokens::IsNumber( concurrency ) &&
+            ( ::std::stol( concurrency ) > 0 ) )
+        {
+            verifiers = ::std::min< ::std::ptrdiff_t >( ::std::stol( concurrency ), ::std::counting_semaphore<>::max() );
+        }
+        // Verifications in flight keep the previous semaphore alive
+        m_verifiers = ::std::make_shared< ::std::counting_semaphore<> >( verifiers );
         if( !a_ini.ReadValue( "settings", "access", m_file ) || ( m_file.length() == 0 ) )
         {
-            m_entries.clear();
             m_file.clear();
-            m_fileHandle.reset();
             m_enabled = false;
-            m_loaded  = false;
             m_realm.clear();
-            m_accessUsers.clear();
-            m_accessFile.clear();
-            m_accessHandle.reset();
-            m_accessLoaded = false;
             return false;
         }
-        m_fileHandle = ::std::make_shared< File >( m_file.c_str(), FileMode::DefaultRead );
         m_enabled = true;
-        m_loaded  = false;
         m_realm = "Restricted";
         a_ini.ReadValue( "settings", "realm", m_realm );
+
+        // Watch before the first load so no change can fall in between
+        m_fileWatch = FileWatcher::Shared().Watch( m_file, [ this ]( const ::std::string &a_path )
+        {
+            Reload( a_path );
+        } );
+        auto tables = LoadTables( m_file );
+        if( tables )
+        {
+            tables->generation = ++m_generation;
+        }
+        m_tables.store( tables );
         return true;
     }
 
+    void HttpAccess::Reload( const ::std::string &a_path )
+    {
+        // Parse without the lock; requests keep using the current tables
+        auto tables = LoadTables( a_path );
+        utils::Lock lock( this );
+        if( !m_enabled || ( a_path != m_file ) )
+        {
+            // Reconfigured while this was loading
+            return;
+        }
+        if( tables )
+        {
+            tables->generation = ++m_generation;
+        }
+        m_tables.store( tables );
+    }
+
+    void HttpAccess::ForgetAccessList( const ::std::string &a_accessPath )
+    {
+        {
+            utils::Lock lock( this );
+            m_accessLists.erase( a_accessPath );
+        }
+        // Paths resolved to the old list look it up again
+        utils::Lock lock( &m_accessCache );
+        m_accessCache.entries.clear();
+        m_accessCache.order.clear();
+        ++m_accessCache.generation;
+    }
+
     bool HttpAccess::Enabled() const
     {
+        utils::SharedLock lock( this );
         return m_enabled;
     }
 
     bool HttpAccess::IsAuthorized( HttpRequest &a_request, const ::std::string &a_path )
     {
-        utils::Lock lock( this );
-        m_lastAuth.enabled = m_enabled;
-        m_lastAuth.authorized = false;
-        m_lastAuth.headerPresent = false;
-        m_lastAuth.schemeValid = false;
-        m_lastAuth.decoded = false;
-        m_lastAuth.credentialsValid = false;
-        m_lastAuth.user.clear();
-        m_lastAuth.reason.clear();
-        if( !m_enabled )
-        {
-            m_lastAuth.authorized = true;
-            m_lastAuth.reason = "access disabled";
+        AuthResult result;
+        bool authorized = IsAuthorized( a_request, a_path, result );
+        utils::Lock lock( &m_lastAuth );
+        m_lastAuth.result = result;
+        return authorized;
+    }
+
+    bool HttpAccess::IsAuthorized( HttpRequest &a_request, const ::std::string &a_path, AuthResult &a_result )
+    {
+        a_result.enabled = Enabled();
+        a_result.authorized = false;
+        a_result.headerPresent = false;
+        a_result.schemeValid = false;
+        a_result.decoded = false;
+        a_result.credentialsValid = false;
+        a_result.user.clear();
+        a_result.reason.clear();
+        if( !a_result.enabled )
+        {
+            a_result.authorized = true;
+            a_result.reason = "access disabled";
             return true;
         }
-        if( !RefreshIfNeeded() )
+        auto tables = m_tables.load();
+        if( !tables )
         {
-            m_lastAuth.reason = "access list unavailable";
+            a_result.reason = "access list unavailable";
             return false;
         }
 
         ::std::string header;
         if( !a_request.HeaderValue( "authorization", header ) )
         {
-            m_lastAuth.reason = "missing authorization header";
+            a_result.reason = "missing authorization header";
             return false;
         }
-        m_lastAuth.headerPresent = true;
+        a_result.headerPresent = true;
         Tokens::TrimSpace( header );
         ::std::string scheme;
         ::std::string encoded;
         auto space = header.find( ' ' );
         if( space == ::std::string::npos )
         {
-            m_lastAuth.reason = "malformed authorization header";
+            a_result.reason = "malformed authorization header";
             return false;
         }
         scheme  = header.substr( 0, space );
@@ -113,64 +234,90 @@ namespace utils
         Tokens::MakeUpper( scheme );
         if( scheme != "BASIC" )
         {
-            m_lastAuth.reason = "unsupported authorization scheme";
+            a_result.reason = "unsupported authorization scheme";
             return false;
         }
-        m_lastAuth.schemeValid = true;
+        a_result.schemeValid = true;
 
-        ::std::string decoded;
-        if( !DecodeBase64( encoded, decoded ) )
+        // The digest stands in for the credentials so the cache never holds
+        // a password
+        uint8_t digest[ Sha1::DIGESTLEN ];
+        Sha1::Hash( reinterpret_cast< const uint8_t * >( encoded.c_str() ), encoded.length(), digest );
+        ::std::string key( reinterpret_cast< const char * >( digest ), sizeof( digest ) );
+        uint64_t generation = tables->generation;
+        ::std::string user;
+        bool cached = FindCached( key, generation, user );
+        bool valid  = cached;
+        if( cached )
         {
-            m_lastAuth.reason = "invalid base64 credentials";
-            return false;
+            a_result.decoded = true;
+            a_result.user    = user;
         }
-        auto colon = decoded.find( ':' );
-        if( colon == ::std::string::npos )
+        else
         {
-            m_lastAuth.reason = "invalid credential format";
-            return false;
+            ::std::string decoded;
+            if( !Base64::Decode( encoded, decoded ) )
+            {
+                a_result.reason = "invalid base64 credentials";
+                return false;
+            }
+            auto colon = decoded.find( ':' );
+            if( colon == ::std::string::npos )
+            {
+                a_result.reason = "invalid credential format";
+                return false;
+            }
+            user = decoded.substr( 0, colon );
+            ::std::string pass = decoded.substr( colon + 1 );
+            a_result.decoded = true;
+            a_result.user = user;
+            valid = CheckCredentials( *tables, user, pass );
+            if( valid )
+            {
+                StoreCached( key, generation, user );
+            }
         }
-        ::std::string user = decoded.substr( 0, colon );
-        ::std::string pass = decoded.substr( colon + 1 );
-        m_lastAuth.decoded = true;
-        m_lastAuth.user = user;
-        if( CheckCredentials( user, pass ) )
+        if( valid )
         {
-            if( !RefreshAccessList( a_path ) )
+            ::std::shared_ptr< const AccessList > list;
+            if( !ResolveAccessList( a_path, list ) )
             {
-                m_lastAuth.reason = "access list unavailable";
+                a_result.reason = "access list unavailable";
                 return false;
             }
-            if( !IsUserAllowed( user ) )
+            if( list && ( 0 == list->users.count( user ) ) )
             {
-                m_lastAuth.reason = "user not permitted";
+                a_result.reason = "user not permitted";
                 return false;
             }
-            m_lastAuth.authorized = true;
-            m_lastAuth.credentialsValid = true;
-            m_lastAuth.reason = "authorized";
+            a_result.authorized = true;
+            a_result.credentialsValid = true;
+            a_result.reason = cached? "authorized (cached)": "authorized";
             return true;
         }
-        m_lastAuth.reason = "invalid credentials";
+        a_result.reason = "invalid credentials";
         return false;
     }
 
     void HttpAccess::GetLastResult( AuthResult &a_result )
     {
-        utils::Lock lock( this );
-        a_result = m_lastAuth;
+        utils::Lock lock( &m_lastAuth );
+        a_result = m_lastAuth.result;
     }
 
     int32_t HttpAccess::RespondUnauthorized( ::std::shared_ptr< Socket > &a_socket )
     {
-        utils::Lock lock( this );
         if( !a_socket || !( a_socket->Valid() ) )
         {
             return -1;
         }
         utils::Lock valueLock( a_socket.get() );
 
-        ::std::string realm = m_realm;
+        ::std::string realm;
+        {
+            utils::SharedLock lock( this );
+            realm = m_realm;
+        }
         if( realm.length() == 0 )
         {
             realm = "Restricted";
@@ -194,41 +341,70 @@ namespace utils
         return 401;
     }
 
-    bool HttpAccess::RefreshIfNeeded()
+    bool HttpAccess::FindCached( const ::std::string &a_key, uint64_t a_generation, ::std::string &a_user )
     {
-        if( m_file.length() == 0 )
+        utils::SharedLock lock( &m_authCache );
+        auto found = m_authCache.entries.find( a_key );
+        if( ( found == m_authCache.entries.end() ) ||
+            ( found->second.generation != a_generation ) ||
+            ( found->second.expires <= ::std::chrono::steady_clock::now() ) )
         {
             return false;
         }
-        if( !m_fileHandle || !m_fileHandle->Exists() )
+        a_user = found->second.user;
+        return true;
+    }
+
+    void HttpAccess::StoreCached( const ::std::string &a_key, uint64_t a_generation, const ::std::string &a_user )
+    {
+        utils::Lock lock( &m_authCache );
+        if( ( 0 == m_authCache.capacity ) || ( 0 == m_authCache.ttl ) )
         {
-            return false;
+            return;
         }
-        if( m_loaded && !m_fileHandle->IsModified() )
+        auto now   = ::std::chrono::steady_clock::now();
+        auto found = m_authCache.entries.find( a_key );
+        if( found == m_authCache.entries.end() )
         {
-            return true;
+            // Drop stale entries from the old end, then the oldest if still
+            // full, without scanning the rest under the lock
+            while( !m_authCache.order.empty() )
+            {
+                auto oldest = m_authCache.entries.find( m_authCache.order.front() );
+                if( ( m_authCache.entries.size() < m_authCache.capacity ) &&
+                    ( oldest->second.generation == a_generation ) && ( oldest->second.expires > now ) )
+                {
+                    break;
+                }
+                m_authCache.entries.erase( oldest );
+                m_authCache.order.pop_front();
+            }
+            found = m_authCache.entries.emplace( a_key, CachedAuth() ).first;
+            found->second.position = m_authCache.order.insert( m_authCache.order.end(), a_key );
         }
-        if( !LoadEntries() )
+        else
         {
-            return false;
+            m_authCache.order.splice( m_authCache.order.end(), m_authCache.order, found->second.position );
         }
-        return true;
+        found->second.user       = a_user;
+        found->second.generation = a_generation;
+        found->second.expires    = now + ::std::chrono::seconds( m_authCache.ttl );
     }
 
-    bool HttpAccess::LoadEntries()
+    ::std::shared_ptr< HttpAccess::Tables > HttpAccess::LoadTables( const ::std::string &a_path )
     {
-        if( !m_fileHandle || !m_fileHandle->Exists() )
+        File file( a_path.c_str(), FileMode::DefaultRead );
+        if( !file.IsFile() )
         {
-            return false;
+            return nullptr;
         }
-        m_entries.clear();
+        auto tables = ::std::make_shared< Tables >();
         auto buffer = ::std::make_shared< Buffer >( MAXBUFFERLEN );
-        if( !buffer )
+        if( !tables || !buffer )
         {
-            return false;
+            return nullptr;
         }
-        m_fileHandle->Seek( 0 );
-        while( TokenTypes::Line == Tokens::GetLine( *m_fileHandle, *buffer ) )
+        while( TokenTypes::Line == Tokens::GetLine( file, *buffer ) )
         {
             ::std::string line;
             Tokens::GetLine( *buffer, line );
@@ -242,36 +418,13 @@ namespace utils
             {
                 continue;
             }
-            ParseEntry( line );
+            ParseEntry( line, *tables );
         }
-        m_fileHandle->Close();
-        m_loaded  = true;
-        return true;
+        file.Close();
+        return tables;
     }
 
-    bool HttpAccess::ParseEntry( const ::std::string &a_line )
-    {
-        auto split = a_line.find( ':' );
-        if( split == ::std::string::npos )
-        {
-            return false;
-        }
-        ::std::string user = a_line.substr( 0, split );
-        ::std::string pass = a_line.substr( split + 1 );
-        Tokens::TrimSpace( user );
-        Tokens::TrimSpace( pass );
-        if( user.length() == 0 )
-        {
-            return false;
-        }
-        Entry entry;
-        entry.user = user;
-        entry.pass = pass;
-        m_entries.push_back( entry );
-        return true;
-    }
-
-    bool HttpAccess::CheckCredentials( const ::std::string &a_user, const ::std::string &a_pass )
+    bool HttpAccess::ParseEntry( const ::std::string &a_line, Tables &a_tables )
     {
         auto startsWithUpper = []( const ::std::string &a_value, const ::std::string &a_prefix )
         {
@@ -293,107 +446,222 @@ namespace utils
             }
             return true;
         };
-        auto trimPadding = []( ::std::string a_value )
+
+        auto split = a_line.find( ':' );
+        if( split == ::std::string::npos )
         {
-            while( ( a_value.length() > 0 ) && ( a_value[ a_value.length() - 1 ] == '=' ) )
+            return false;
+        }
+        ::std::string user = a_line.substr( 0, split );
+        ::std::string pass = a_line.substr( split + 1 );
+        Tokens::TrimSpace( user );
+        Tokens::TrimSpace( pass );
+        if( user.length() == 0 )
+        {
+            return false;
+        }
+        Entry entry;
+        const ::std::string shaPrefix   = "{SHA}";
+        const ::std::string plainPrefix = "{PLAIN}";
+        if( startsWithUpper( pass, shaPrefix ) )
+        {
+            // Keep the decoded digest so a check is one hash and a compare
+            entry.scheme = Scheme::Sha;
+            if( !Base64::Decode( pass.substr( shaPrefix.length() ), entry.pass ) || ( entry.pass.length() != Sha1::DIGESTLEN ) )
             {
-                a_value.pop_back();
+                return false;
             }
-            return a_value;
-        };
+        }
+        else if( startsWithUpper( pass, plainPrefix ) )
+        {
+            entry.scheme = Scheme::Plain;
+            entry.pass   = pass.substr( plainPrefix.length() );
+        }
+        else
+        {
+            entry.scheme = Scheme::Crypt;
+            entry.pass   = pass;
+        }
+        a_tables.entries.emplace( user, entry );
+        return true;
+    }
 
-        for( const auto &entry : m_entries )
+    bool HttpAccess::CheckCredentials( const Tables &a_tables, const ::std::string &a_user, const ::std::string &a_pass )
+    {
+        // The tables are immutable and the caller holds a reference, so the
+        // slow part runs unlocked and never holds up a reload
+        ::std::shared_ptr< ::std::counting_semaphore<> > verifiers;
         {
-            if( entry.user != a_user )
-            {
-                continue;
-            }
-            const ::std::string shaPrefix = "{SHA}";
-            if( startsWithUpper( entry.pass, shaPrefix ) )
-            {
-                uint8_t digest[ 20 ];
-                Sha1( reinterpret_cast< const uint8_t * >( a_pass.c_str() ), a_pass.length(), digest );
-                ::std::string encodedString = Base64Encode( digest, sizeof( digest ) );
-                ::std::string stored = entry.pass.substr( shaPrefix.length() );
-                if( stored == encodedString )
-                {
-                    return true;
-                }
-                if( trimPadding( stored ) == trimPadding( encodedString ) )
-                {
-                    return true;
-                }
-                continue;
-            }
-            const ::std::string plainPrefix = "{PLAIN}";
-            if( startsWithUpper( entry.pass, plainPrefix ) )
-            {
-                if( entry.pass.substr( plainPrefix.length() ) == a_pass )
-                {
-                    return true;
-                }
-                continue;
-            }
-            if( entry.pass == a_pass )
+            utils::SharedLock lock( this );
+            verifiers = m_verifiers;
+        }
+        auto range = a_tables.entries.equal_range( a_user );
+        for( auto entry = range.first; entry != range.second; ++entry )
+        {
+            if( VerifyPassword( entry->second, a_pass, verifiers.get() ) )
             {
                 return true;
             }
-            if( entry.pass.length() > 0 )
-            {
-                const char *hashed = crypt( a_pass.c_str(), entry.pass.c_str() );
-                if( hashed && ( strcmp( hashed, entry.pass.c_str() ) == 0 ) )
-                {
-                    return true;
-                }
-            }
         }
         return false;
     }
 
-    bool HttpAccess::RefreshAccessList( const ::std::string &a_path )
+    bool HttpAccess::VerifyPassword( const Entry &a_entry, const ::std::string &a_pass,
+                                     ::std::counting_semaphore<> *a_verifiers ) const
     {
-        ::std::string accessPath;
-        if( !FindAccessFile( a_path, accessPath ) )
+        switch( a_entry.scheme )
+        {
+            case Scheme::Sha:
+            {
+                uint8_t digest[ Sha1::DIGESTLEN ];
+                Sha1::Hash( reinterpret_cast< const uint8_t * >( a_pass.c_str() ), a_pass.length(), digest );
+                return ( 0 == memcmp( digest, a_entry.pass.data(), sizeof( digest ) ) );
+            }
+            case Scheme::Plain:
+                return ( a_entry.pass == a_pass );
+            case Scheme::Crypt:
+                break;
+        }
+        if( a_entry.pass == a_pass )
         {
-            m_accessUsers.clear();
-            m_accessFile.clear();
-            m_accessHandle.reset();
-            m_accessLoaded = false;
             return true;
         }
+        if( a_entry.pass.length() == 0 )
+        {
+            return false;
+        }
 
-        if( accessPath != m_accessFile )
+        // crypt_data is tens of KiB; allocate it once per thread instead of
+        // zeroing a fresh one on the stack for every attempt
+        static thread_local ::std::unique_ptr< struct crypt_data > data;
+        if( !data )
+        {
+            data = ::std::make_unique< struct crypt_data >();
+        }
+        if( a_verifiers )
         {
-            m_accessFile = accessPath;
-            m_accessHandle = ::std::make_shared< File >( m_accessFile.c_str(), FileMode::DefaultRead );
-            m_accessLoaded = false;
+            a_verifiers->acquire();
         }
+        const char *hashed = crypt_r( a_pass.c_str(), a_entry.pass.c_str(), data.get() );
+        bool        match  = hashed && ( strcmp( hashed, a_entry.pass.c_str() ) == 0 );
+        if( a_verifiers )
+        {
+            a_verifiers->release();
+        }
+        return match;
+    }
 
-        if( !m_accessHandle || !m_accessHandle->Exists() )
+    bool HttpAccess::ResolveAccessList( const ::std::string &a_path, ::std::shared_ptr< const AccessList > &a_list )
+    {
+        a_list.reset();
+        if( a_path.length() == 0 )
+        {
+            return true;
+        }
+        // Every file in a directory is governed by the same .htaccess, so
+        // the directory is resolved once for all of them
+        ::std::string directory = a_path.substr( 0, a_path.find_last_of( '/' ) + 1 );
+        if( directory.length() == 0 )
+        {
+            directory = "./";
+        }
+        auto     now        = ::std::chrono::steady_clock::now();
+        uint64_t generation = 0;
+        {
+            utils::SharedLock lock( &m_accessCache );
+            auto found = m_accessCache.entries.find( directory );
+            if( ( found != m_accessCache.entries.end() ) && ( found->second.expires > now ) )
+            {
+                a_list = found->second.list;
+                return true;
+            }
+            generation = m_accessCache.generation;
+        }
+
+        ::std::string accessPath;
+        if( FindAccessFile( directory, accessPath ) && !LoadAccessList( accessPath, a_list ) )
         {
+            // Not cached, so an unreadable file is retried next time
             return false;
         }
-        if( m_accessLoaded && !m_accessHandle->IsModified() )
+
+        utils::Lock lock( &m_accessCache );
+        if( ( 0 == m_accessCache.capacity ) || ( 0 == m_accessCache.ttl ) ||
+            ( m_accessCache.generation != generation ) )
         {
             return true;
         }
-        return LoadAccessList();
+        auto found = m_accessCache.entries.find( directory );
+        if( found == m_accessCache.entries.end() )
+        {
+            // Drop stale entries from the old end, then the oldest if still
+            // full; each entry is dropped at most once
+            while( !m_accessCache.order.empty() )
+            {
+                auto oldest = m_accessCache.entries.find( m_accessCache.order.front() );
+                if( ( m_accessCache.entries.size() < m_accessCache.capacity ) && ( oldest->second.expires > now ) )
+                {
+                    break;
+                }
+                m_accessCache.entries.erase( oldest );
+                m_accessCache.order.pop_front();
+            }
+            found = m_accessCache.entries.emplace( directory, CachedAccess() ).first;
+            found->second.position = m_accessCache.order.insert( m_accessCache.order.end(), directory );
+        }
+        else
+        {
+            m_accessCache.order.splice( m_accessCache.order.end(), m_accessCache.order, found->second.position );
+        }
+        found->second.list    = a_list;
+        found->second.expires = now + ::std::chrono::seconds( m_accessCache.ttl );
+        return true;
     }
 
-    bool HttpAccess::LoadAccessList()
+    bool HttpAccess::LoadAccessList( const ::std::string &a_accessPath, ::std::shared_ptr< const AccessList > &a_list )
     {
-        if( !m_accessHandle || !m_accessHandle->Exists() )
+        {
+            // Known lists are watched, so they are current without a stat
+            utils::SharedLock lock( this );
+            auto found = m_accessLists.find( a_accessPath );
+            if( found != m_accessLists.end() )
+            {
+                a_list = found->second;
+                return true;
+            }
+        }
+        uint64_t             generation = 0;
+        FileWatcher::WatchId watch      = 0;
+        {
+            utils::SharedLock lock( &m_accessCache );
+            generation = m_accessCache.generation;
+        }
+        {
+            utils::Lock lock( this );
+            auto found = m_accessWatches.find( a_accessPath );
+            if( found == m_accessWatches.end() )
+            {
+                found = m_accessWatches.emplace( a_accessPath, FileWatcher::Shared().Watch( a_accessPath, [ this ]( const ::std::string &a_path )
+                {
+                    ForgetAccessList( a_path );
+                } ) ).first;
+            }
+            watch = found->second;
+        }
+
+        // Parse unlocked into a new list; readers of the old one keep it
+        File file( a_accessPath.c_str(), FileMode::DefaultRead );
+        if( !file.IsFile() )
         {
             return false;
         }
-        m_accessUsers.clear();
+        auto list = ::std::make_shared< AccessList >();
         auto buffer = ::std::make_shared< Buffer >( MAXBUFFERLEN );
-        if( !buffer )
+        if( !list || !buffer )
         {
             return false;
         }
-        m_accessHandle->Seek( 0 );
-        while( TokenTypes::Line == Tokens::GetLine( *m_accessHandle, *buffer ) )
+        while( TokenTypes::Line == Tokens::GetLine( file, *buffer ) )
         {
             ::std::string line;
             Tokens::GetLine( *buffer, line );
@@ -423,10 +691,20 @@ namespace utils
             {
                 continue;
             }
-            m_accessUsers.push_back( user );
+            list->users.insert( user );
         }
-        m_accessHandle->Close();
-        m_accessLoaded = true;
+        file.Close();
+
+        {
+            // Share the list only if it cannot have missed a change
+            utils::Lock lock( this );
+            utils::SharedLock cacheLock( &m_accessCache );
+            if( ( 0 != watch ) && ( m_accessCache.generation == generation ) )
+            {
+                m_accessLists[ a_accessPath ] = list;
+            }
+        }
+        a_list = list;
         return true;
     }
 
@@ -516,208 +794,4 @@ namespace utils
         }
         return false;
     }
-
-    bool HttpAccess::IsUserAllowed( const ::std::string &a_user ) const
-    {
-        if( m_accessUsers.empty() )
-        {
-            return m_accessFile.length() == 0;
-        }
-        for( const auto &user : m_accessUsers )
-        {
-            if( user == a_user )
-            {
-                return true;
-            }
-        }
-        return false;
-    }
-
-    bool HttpAccess::DecodeBase64( const ::std::string &a_input, ::std::string &a_output ) const
-    {
-        a_output.clear();
-        int value = 0;
-        int bits  = -8;
-
-        for( size_t i = 0; i < a_input.length(); ++i )
-        {
-            char c = a_input[ i ];
-            if( Tokens::IsSpace( static_cast< uint8_t >( c ) ) )
-            {
-                continue;
-            }
-            if( c == '=' )
-            {
-                break;
-            }
-            int decoded = Base64Value( c );
-            if( decoded < 0 )
-            {
-                return false;
-            }
-            value = ( value << 6 ) + decoded;
-            bits += 6;
-            if( bits >= 0 )
-            {
-                a_output += static_cast< char >( ( value >> bits ) & 0xFF );
-                bits -= 8;
-            }
-        }
-        return true;
-    }
-
-    int HttpAccess::Base64Value( char a_char ) const
-    {
-        if( ( a_char >= 'A' ) && ( a_char <= 'Z' ) )
-        {
-            return a_char - 'A';
-        }
-        if( ( a_char >= 'a' ) && ( a_char <= 'z' ) )
-        {
-            return a_char - 'a' + 26;
-        }
-        if( ( a_char >= '0' ) && ( a_char <= '9' ) )
-        {
-            return a_char - '0' + 52;
-        }
-        if( a_char == '+' )
-        {
-            return 62;
-        }
-        if( a_char == '/' )
-        {
-            return 63;
-        }
-        return -1;
-    }
-
-    void HttpAccess::Sha1( const uint8_t *a_data, size_t a_len, uint8_t a_output[ 20 ] ) const
-    {
-        uint32_t h0 = 0x67452301;
-        uint32_t h1 = 0xEFCDAB89;
-        uint32_t h2 = 0x98BADCFE;
-        uint32_t h3 = 0x10325476;
-        uint32_t h4 = 0xC3D2E1F0;
-
-        uint64_t bitLen = static_cast< uint64_t >( a_len ) * 8;
-        size_t totalLen = a_len + 1;
-        while( ( totalLen % 64 ) != 56 )
-        {
-            ++totalLen;
-        }
-        ::std::vector< uint8_t > buffer( totalLen + 8, 0 );
-        for( size_t i = 0; i < a_len; ++i )
-        {
-            buffer[ i ] = a_data[ i ];
-        }
-        buffer[ a_len ] = 0x80;
-        for( size_t i = 0; i < 8; ++i )
-        {
-            buffer[ totalLen + i ] = static_cast< uint8_t >( ( bitLen >> ( 56 - ( i * 8 ) ) ) & 0xFF );
-        }
-
-        for( size_t chunk = 0; chunk < buffer.size(); chunk += 64 )
-        {
-            uint32_t w[ 80 ];
-            for( int i = 0; i < 16; ++i )
-            {
-                size_t index = chunk + ( i * 4 );
-                w[ i ] = ( buffer[ index ] << 24 ) |
-                         ( buffer[ index + 1 ] << 16 ) |
-                         ( buffer[ index + 2 ] << 8 ) |
-                         ( buffer[ index + 3 ] );
-            }
-            for( int i = 16; i < 80; ++i )
-            {
-                uint32_t value = w[ i - 3 ] ^ w[ i - 8 ] ^ w[ i - 14 ] ^ w[ i - 16 ];
-                w[ i ] = ( value << 1 ) | ( value >> 31 );
-            }
-
-            uint32_t a = h0;
-            uint32_t b = h1;
-            uint32_t c = h2;
-            uint32_t d = h3;
-            uint32_t e = h4;
-
-            for( int i = 0; i < 80; ++i )
-            {
-                uint32_t f = 0;
-                uint32_t k = 0;
-                if( i < 20 )
-                {
-                    f = ( b & c ) | ( ( ~b ) & d );
-                    k = 0x5A827999;
-                }
-                else if( i < 40 )
-                {
-                    f = b ^ c ^ d;
-                    k = 0x6ED9EBA1;
-                }
-                else if( i < 60 )
-                {
-                    f = ( b & c ) | ( b & d ) | ( c & d );
-                    k = 0x8F1BBCDC;
-                }
-                else
-                {
-                    f = b ^ c ^ d;
-                    k = 0xCA62C1D6;
-                }
-
-                uint32_t temp = ( ( a << 5 ) | ( a >> 27 ) ) + f + e + k + w[ i ];
-                e = d;
-                d = c;
-                c = ( b << 30 ) | ( b >> 2 );
-                b = a;
-                a = temp;
-            }
-
-            h0 += a;
-            h1 += b;
-            h2 += c;
-            h3 += d;
-            h4 += e;
-        }
-
-        a_output[ 0 ] = ( h0 >> 24 ) & 0xFF;
-        a_output[ 1 ] = ( h0 >> 16 ) & 0xFF;
-        a_output[ 2 ] = ( h0 >> 8 ) & 0xFF;
-        a_output[ 3 ] = h0 & 0xFF;
-        a_output[ 4 ] = ( h1 >> 24 ) & 0xFF;
-        a_output[ 5 ] = ( h1 >> 16 ) & 0xFF;
-        a_output[ 6 ] = ( h1 >> 8 ) & 0xFF;
-        a_output[ 7 ] = h1 & 0xFF;
-        a_output[ 8 ] = ( h2 >> 24 ) & 0xFF;
-        a_output[ 9 ] = ( h2 >> 16 ) & 0xFF;
-        a_output[ 10 ] = ( h2 >> 8 ) & 0xFF;
-        a_output[ 11 ] = h2 & 0xFF;
-        a_output[ 12 ] = ( h3 >> 24 ) & 0xFF;
-        a_output[ 13 ] = ( h3 >> 16 ) & 0xFF;
-        a_output[ 14 ] = ( h3 >> 8 ) & 0xFF;
-        a_output[ 15 ] = h3 & 0xFF;
-        a_output[ 16 ] = ( h4 >> 24 ) & 0xFF;
-        a_output[ 17 ] = ( h4 >> 16 ) & 0xFF;
-        a_output[ 18 ] = ( h4 >> 8 ) & 0xFF;
-        a_output[ 19 ] = h4 & 0xFF;
-    }
-
-    ::std::string HttpAccess::Base64Encode( const uint8_t *a_data, size_t a_len ) const
-    {
-        static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-        ::std::string out;
-        size_t i = 0;
-        while( i < a_len )
-        {
-            size_t remaining = a_len - i;
-            uint32_t octet_a = a_data[ i++ ];
-            uint32_t octet_b = ( remaining > 1 ) ? a_data[ i++ ] : 0;
-            uint32_t octet_c = ( remaining > 2 ) ? a_data[ i++ ] : 0;
-            uint32_t triple = ( octet_a << 16 ) | ( octet_b << 8 ) | octet_c;
-            out += table[ ( triple >> 18 ) & 0x3F ];
-            out += table[ ( triple >> 12 ) & 0x3F ];
-            out += ( remaining > 1 ) ? table[ ( triple >> 6 ) & 0x3F ] : '=';
-            out += ( remaining > 2 ) ? table[ triple & 0x3F ] : '=';
-        }
-        return out;
-    }
 }
@@ -6,6 +6,8 @@
 
 #include <utils/HttpHelpers.hpp>
 #include <utils/Tokens.hpp>
+#include <algorithm>
+#include <stdlib.h>
 #include <sys/stat.h>
 
 #define MAXBUFFERLEN 65536
@@ -50,54 +52,202 @@ namespace utils
     ::std::string HttpHelpers::HtmlEscape( const ::std::string &a_string )
     {
         ::std::string newString;
+        HtmlEscape( a_string.data(), a_string.length(), newString );
+        return newString;
+    }
 
-        for( uint32_t i = 0; i < a_string.length(); ++i )
+    void HttpHelpers::HtmlEscape( const char *a_string, size_t a_len, ::std::string &a_output )
+    {
+        // Copy runs of plain characters in one go
+        size_t run = 0;
+        for( size_t i = 0; i < a_len; ++i )
         {
+            const char *entity = nullptr;
             switch( a_string[ i ] )
             {
-                case '&': newString += "&amp;";
+                case '&': entity = "&amp;";
                     break;
-                case '<': newString += "&lt;";
+                case '<': entity = "&lt;";
                     break;
-                case '>': newString += "&gt;";
+                case '>': entity = "&gt;";
                     break;
-                case '"': newString += "&quot;";
+                case '"': entity = "&quot;";
                     break;
-                case '\'': newString += "&#39;";
+                case '\'': entity = "&#39;";
                     break;
-                default: newString += a_string[ i ];
+                default:
                     break;
             }
+            if( nullptr != entity )
+            {
+                a_output.append( a_string + run, i - run );
+                a_output += entity;
+                run = i + 1;
+            }
         }
+        a_output.append( a_string + run, a_len - run );
+    }
 
+    ::std::string HttpHelpers::UriEncode( const ::std::string &a_string )
+    {
+        ::std::string newString;
+        UriEncode( a_string.data(), a_string.length(), newString );
         return newString;
     }
 
+    void HttpHelpers::UriEncode( const char *a_string, size_t a_len, ::std::string &a_output )
+    {
+        size_t run = 0;
+        for( size_t i = 0; i < a_len; ++i )
+        {
+            uint8_t c = static_cast< uint8_t >( a_string[ i ] );
+            if( !Tokens::IsLetter( c ) &&
+                !Tokens::IsNumber( c ) &&
+                ( c != '-' ) &&
+                ( c != '_' ) &&
+                ( c != '.' ) &&
+                ( c != '~' ) )
+            {
+                char escaped[ 3 ] = { '%', HttpHelpers::IntToHex( c >> 4 ), HttpHelpers::IntToHex( c & 0x0F ) };
+                a_output.append( a_string + run, i - run );
+                a_output.append( escaped, sizeof( escaped ) );
+                run = i + 1;
+            }
+        }
+        a_output.append( a_string + run, a_len - run );
+    }
 
-    ::std::string HttpHelpers::UriEncode( const ::std::string &a_string )
+    // Length of the well-formed UTF-8 sequence starting a_string[ 0 ], or
+    // zero if it is not one (overlong forms, surrogates, and code points
+    // past U+10FFFF included)
+    static size_t Utf8Length( const uint8_t *a_string, size_t a_len )
     {
-        ::std::string newString;
+        uint8_t c     = a_string[ 0 ];
+        size_t  count = 0;
+        uint8_t low   = 0x80;
+        uint8_t high  = 0xBF;
+        if( ( c >= 0xC2 ) && ( c <= 0xDF ) )
+        {
+            count = 2;
+        }
+        else if( ( c >= 0xE0 ) && ( c <= 0xEF ) )
+        {
+            count = 3;
+            low   = ( c == 0xE0 )? 0xA0: 0x80;
+            high  = ( c == 0xED )? 0x9F: 0xBF;
+        }
+        else if( ( c >= 0xF0 ) && ( c <= 0xF4 ) )
+        {
+            count = 4;
+            low   = ( c == 0xF0 )? 0x90: 0x80;
+            high  = ( c == 0xF4 )? 0x8F: 0xBF;
+        }
+        if( ( 0 == count ) || ( count > a_len ) || ( a_string[ 1 ] < low ) || ( a_string[ 1 ] > high ) )
+        {
+            return 0;
+        }
+        for( size_t i = 2; i < count; ++i )
+        {
+            if( ( a_string[ i ] & 0xC0 ) != 0x80 )
+            {
+                return 0;
+            }
+        }
+        return count;
+    }
 
-        for( uint32_t i = 0; i < a_string.length(); ++i )
+    void HttpHelpers::JsonEscape( const char *a_string, size_t a_len, ::std::string &a_output )
+    {
+        const uint8_t *bytes = reinterpret_cast< const uint8_t * >( a_string );
+        size_t         run   = 0;
+        for( size_t i = 0; i < a_len; ++i )
         {
-            if( !Tokens::IsLetter( ( uint8_t )a_string[ i ] ) &&
-                !Tokens::IsNumber( ( uint8_t )a_string[ i ] ) &&
-                ( a_string[ i ] != '-' ) &&
-                ( a_string[ i ] != '_' ) &&
-                ( a_string[ i ] != '.' ) &&
-                ( a_string[ i ] != '~' ) )
+            uint8_t c = bytes[ i ];
+            if( ( c >= 0x20 ) && ( c < 0x80 ) && ( c != '"' ) && ( c != '\\' ) )
             {
-                newString += "%";
-                newString += HttpHelpers::IntToHex( a_string[ i ] >>   4 );
-                newString += HttpHelpers::IntToHex( a_string[ i ] & 0x0F );
+                continue;
             }
-            else
+            if( c >= 0x80 )
+            {
+                size_t length = Utf8Length( bytes + i, a_len - i );
+                if( length > 0 )
+                {
+                    i += length - 1;
+                    continue;
+                }
+            }
+            a_output.append( a_string + run, i - run );
+            run = i + 1;
+            switch( c )
             {
-                newString += a_string[ i ];
+                case '"': a_output += "\\\"";
+                    break;
+                case '\\': a_output += "\\\\";
+                    break;
+                case '\n': a_output += "\\n";
+                    break;
+                case '\r': a_output += "\\r";
+                    break;
+                case '\t': a_output += "\\t";
+                    break;
+                default:
+                {
+                    if( c >= 0x80 )
+                    {
+                        // Not UTF-8, so not valid in JSON; each such byte
+                        // becomes the replacement character
+                        a_output += "\\ufffd";
+                        break;
+                    }
+                    char escaped[ 6 ] = { '\\', 'u', '0', '0', HttpHelpers::IntToHex( c >> 4 ), HttpHelpers::IntToHex( c & 0x0F ) };
+                    a_output.append( escaped, sizeof( escaped ) );
+                    break;
+                }
             }
         }
+        a_output.append( a_string + run, a_len - run );
+    }
 
-        return newString;
+    double HttpHelpers::AcceptQuality( const ::std::string &a_accept, const ::std::string &a_type )
+    {
+        ::std::string major   = a_type.substr( 0, a_type.find( '/' ) ) + "/*";
+        double        quality = 0.0;
+        uint32_t      best    = 0; // Specificity of the range quality came from
+        size_t        start   = 0;
+        while( start <= a_accept.length() )
+        {
+            size_t end = a_accept.find( ',', start );
+            if( end == ::std::string::npos )
+            {
+                end = a_accept.length();
+            }
+            ::std::string range = a_accept.substr( start, end - start );
+            start = end + 1;
+
+            ::std::string parameters;
+            size_t        semicolon = range.find( ';' );
+            if( semicolon != ::std::string::npos )
+            {
+                parameters = range.substr( semicolon + 1 );
+                range.resize( semicolon );
+            }
+            Tokens::TrimSpace( range );
+            Tokens::MakeLower( range );
+            uint32_t specificity = ( range == a_type )? 3: ( ( range == major )? 2: ( ( range == "*/*" )? 1: 0 ) );
+            if( specificity <= best )
+            {
+                continue;
+            }
+            double value = 1.0;
+            size_t q     = parameters.find( "q=" );
+            if( q != ::std::string::npos )
+            {
+                value = ::std::clamp( strtod( parameters.c_str() + q + 2, nullptr ), 0.0, 1.0 );
+            }
+            quality = value;
+            best    = specificity;
+        }
+        return quality;
     }
 
     ::std::string HttpHelpers::UriDecode( const ::std::string &a_string )
@@ -5,15 +5,21 @@
 */
 
 #include <utils/HttpRequest.hpp>
+#include <utils/DirectoryListing.hpp>
 #include <utils/File.hpp>
 #include <utils/Tokens.hpp>
-#include <dirent.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <vector>
 #include <algorithm>
 
 #define MAXBUFFERLEN 65536
+#define HEADERTIMEOUTMS 10000 // Default time allowed for the request line and headers
+#define BODYTIMEOUTMS   30000 // Default time allowed for the request body
+#define IDLETIMEOUTMS   5000  // Default time allowed between received segments
+#define READCHUNK       4096  // Bytes requested from the socket per read
+#define LISTINGCHUNK    256   // Entries rendered per write of a streamed listing
 
 namespace
 {
@@ -30,6 +36,28 @@ namespace
 
 namespace utils
 {
+    // Write all of a_data unless the socket fails
+    static void SendAll( Socket &a_socket, const char *a_data, size_t a_len )
+    {
+        size_t sent = 0;
+        while( ( sent < a_len ) && a_socket.Valid() )
+        {
+            uint32_t length = static_cast< uint32_t >( ::std::min< size_t >( a_len - sent, MAXBUFFERLEN ) );
+            sent += a_socket.Write( reinterpret_cast< const uint8_t * >( a_data + sent ), length );
+        }
+    }
+
+    // Find the '?' that starts the query string, or npos if there is none
+    static size_t FindQuery( const ::std::string &a_uri )
+    {
+        size_t query = a_uri.find( '?' );
+        while( ( query != ::std::string::npos ) && ( query > 0 ) && ( '.' == a_uri[ query - 1 ] ) )
+        {
+            query = a_uri.find( '?', query + 1 );
+        }
+        return query;
+    }
+
     HttpRequest::HttpRequest()
     : m_length ( 0 )
     , m_start  ( -1 )
@@ -37,6 +65,9 @@ namespace utils
     , m_sset   ( false )
     , m_eset   ( false )
     , m_timeout( false )
+    , m_headerTimeout( HEADERTIMEOUTMS )
+    , m_bodyTimeout  ( BODYTIMEOUTMS )
+    , m_idleTimeout  ( IDLETIMEOUTMS )
     {}
 
     HttpRequest::~HttpRequest()
@@ -68,6 +99,43 @@ namespace utils
         return m_uri;
     }
 
+    ::std::string HttpRequest::Path()
+    {
+        utils::Lock lock( this );
+        return m_uri.substr( 0, FindQuery( m_uri ) );
+    }
+
+    bool HttpRequest::QueryValue( const ::std::string &a_key, ::std::string &a_value )
+    {
+        utils::Lock lock( this );
+        a_value.clear();
+        size_t query = FindQuery( m_uri );
+        if( ( query == ::std::string::npos ) || ( a_key.length() == 0 ) )
+        {
+            return false;
+        }
+        for( size_t start = query + 1; start <= m_uri.length(); )
+        {
+            size_t end = m_uri.find( '&', start );
+            if( end == ::std::string::npos )
+            {
+                end = m_uri.length();
+            }
+            size_t equals = m_uri.find( '=', start );
+            size_t nameEnd = ( ( equals != ::std::string::npos ) && ( equals < end ) )? equals: end;
+            if( HttpHelpers::UriDecode( m_uri.substr( start, nameEnd - start ) ) == a_key )
+            {
+                if( nameEnd < end )
+                {
+                    a_value = HttpHelpers::UriDecode( m_uri.substr( nameEnd + 1, end - nameEnd - 1 ) );
+                }
+                return true;
+            }
+            start = end + 1;
+        }
+        return false;
+    }
+
     ::std::string &HttpRequest::Method()
     {
         utils::Lock lock( this );
@@ -80,7 +148,7 @@ namespace utils
         return m_version;
     }
 
-    ::std::shared_ptr< KeyValuePair< ::std::string, ::std::string > > &HttpRequest::Meta()
+    ::std::shared_ptr< HttpRequest::Header > &HttpRequest::Meta()
     {
         utils::Lock lock( this );
         return m_meta;
@@ -90,7 +158,7 @@ namespace utils
     {
         utils::Lock lock( this );
         ::std::string host;
-        ::std::shared_ptr< KeyValuePair< ::std::string, ::std::string > > start = m_meta;
+        ::std::shared_ptr< Header > start = m_meta;
         while( start )
         {
             if( start->Key() == "HOST" )
@@ -113,7 +181,7 @@ namespace utils
         }
         ::std::string key( a_key );
         Tokens::MakeUpper( key );
-        ::std::shared_ptr< KeyValuePair< ::std::string, ::std::string > > start = m_meta;
+        ::std::shared_ptr< Header > start = m_meta;
         while( start )
         {
             if( start->Key() == key )
@@ -151,12 +219,66 @@ namespace utils
         return result;
     }
 
+    void HttpRequest::SetTimeouts( uint32_t a_headerMs, uint32_t a_bodyMs, uint32_t a_idleMs )
+    {
+        utils::Lock lock( this );
+        m_headerTimeout = ( a_headerMs > 0 )? a_headerMs: m_headerTimeout;
+        m_bodyTimeout   = ( a_bodyMs   > 0 )? a_bodyMs:   m_bodyTimeout;
+        m_idleTimeout   = ( a_idleMs   > 0 )? a_idleMs:   m_idleTimeout;
+    }
+
+    bool HttpRequest::TimedOut() const
+    {
+        return m_timeout;
+    }
+
+    bool HttpRequest::Fill( Socket &a_socket, ::std::string &a_pending,
+                            ::std::chrono::steady_clock::time_point a_deadline,
+                            ::std::chrono::steady_clock::time_point &a_lastRead )
+    {
+        uint8_t chunk[ READCHUNK ];
+        while( true )
+        {
+            // Sleep in poll() until data arrives or the nearer of the phase
+            // deadline and the idle deadline passes
+            auto now   = ::std::chrono::steady_clock::now();
+            auto limit = ::std::min( a_deadline, a_lastRead + ::std::chrono::milliseconds( m_idleTimeout ) );
+            if( now >= limit )
+            {
+                m_timeout = true;
+                return false;
+            }
+            auto wait = ::std::chrono::ceil< ::std::chrono::milliseconds >( limit - now ).count();
+            if( !a_socket.WaitForRead( static_cast< int32_t >( ::std::min< int64_t >( wait, INT32_MAX ) ) ) )
+            {
+                // A closed socket fails the wait at once; only a timeout
+                // goes around again to check the deadlines
+                if( !a_socket.Valid() )
+                {
+                    return false;
+                }
+                continue;
+            }
+            // Readable with nothing to read means the peer closed or the
+            // connection was interrupted
+            uint32_t read = a_socket.Read( chunk, sizeof( chunk ) );
+            if( 0 == read )
+            {
+                return false;
+            }
+            a_pending.append( reinterpret_cast< const char * >( chunk ), read );
+            a_lastRead = ::std::chrono::steady_clock::now();
+            return true;
+        }
+    }
+
     bool HttpRequest::Read( ::std::shared_ptr< Socket > &a_socket )
     {
         utils::Lock   lock( this );
-        uint32_t      timeout = 10;
         uint32_t      count = 0;
         ::std::string token;
+        ::std::string pending;    // Received data not yet parsed
+        size_t        offset = 0; // Start of the next line in pending
 
         if( !a_socket )
         {
@@ -177,43 +299,43 @@ namespace utils
             return false;
         }
 
+        auto lastRead = ::std::chrono::steady_clock::now();
+        auto deadline = lastRead + ::std::chrono::milliseconds( m_headerTimeout );
+
         // Get the HTTP request
-        while( a_socket->Valid() && ( timeout > 0 ) )
+        while( true )
         {
             // Read a line of data from the client
-            recvb->Clear(); // Reset the buffer each loop
-            if( Tokens::GetLine( *a_socket, *recvb ) != TokenTypes::Line )
+            size_t newline = pending.find( '\n', offset );
+            if( ::std::string::npos == newline )
             {
-                usleep( 1000 );
-                --timeout;
+                if( ( ( pending.length() - offset ) >= MAXBUFFERLEN ) ||
+                    !Fill( *a_socket, pending, deadline, lastRead ) )
+                {
+                    break;
+                }
                 continue;
             }
+            size_t length = newline - offset;
+            if( ( length > 0 ) && ( '\r' == pending[ newline - 1 ] ) )
+            {
+                --length;
+            }
+            recvb->Clear(); // Reset the buffer each line
+            recvb->Write( reinterpret_cast< const uint8_t * >( pending.data() + offset ), length );
+            offset = newline + 1;
             // Empty line after request
             if( 0 == recvb->Length() )
             {
                 // Get more if there is data involved
                 if( m_length > 0 )
                 {
-                    recvb->Clear();
-                    timeout = 10;
-                    while( ( timeout > 0 ) && a_socket->IsReadable() )
+                    pending.erase( 0, offset );
+                    deadline = ::std::chrono::steady_clock::now() + ::std::chrono::milliseconds( m_bodyTimeout );
+                    while( ( pending.length() < m_length ) && Fill( *a_socket, pending, deadline, lastRead ) )
                     {
-                        if( !a_socket->Read( recvb ) )
-                        {
-                            // Calling IsReadable() incurs a timeout
-                            --timeout;
-                            continue;
-                        }
-                        uint8_t data = 0;
-                        while( recvb->Read( data ) && ( m_body.length() < m_length ) )
-                        {
-                            m_body += ( char )data;
-                        }
-                        if( m_body.length() >= m_length )
-                        {
-                            break;
-                        }
                     }
+                    m_body = pending.substr( 0, m_length );
                 }
                 // This is the end of the HTTP request
                 break;
@@ -251,7 +373,7 @@ namespace utils
                 if( ( count < 100 ) && ( Tokens::GetToken( *recvb, token, ':' ) == TokenTypes::Delineated ) )
                 {
                     ++count;
-                    auto temp = ::std::make_shared< KeyValuePair< ::std::string, ::std::string > >();
+                    auto temp = ::std::make_shared< Header >();
                     if( temp )
                     {
                         temp->Key() = token;
@@ -398,7 +520,6 @@ namespace utils
                 }
             }
         }
-        m_timeout = ( timeout <= 0 );
         return ( !m_timeout && ( m_method.length() > 0 ) && ( m_uri.length() > 0 ) && ( m_version.length() > 0 ) );
     }
 
@@ -421,6 +542,17 @@ namespace utils
             return -1;
         }
 
+        if( m_timeout || ( 0 == m_version.length() ) )
+        {
+            sendb->Write( ( const uint8_t * )"HTTP/1.1 408 TIMEOUT\r\n" );
+            sendb->Write( ( const uint8_t * )"Connection: Close\r\n" );
+            sendb->Write( ( const uint8_t * )"Content-Length: 0\r\n\r\n" );
+            while( sendb->Length() && a_socket->Valid() )
+            {
+                a_socket->Write( sendb );
+            }
+            return 408;
+        }
         bool serverOptions = ( m_method == "OPTIONS" ) && ( m_uri == "*" );
         if( ( ( m_method == "HEAD" ) || ( m_method == "GET" ) || ( m_method == "OPTIONS" ) ) && !serverOptions &&
             !file->Exists() && ( m_response.length() == 0 ) )
@@ -438,17 +570,6 @@ namespace utils
             }
             return -1;
         }
-        if( m_timeout || ( 0 == m_version.length() ) )
-        {
-            sendb->Write( ( const uint8_t * )"HTTP/1.1 408 TIMEOUT\r\n" );
-            sendb->Write( ( const uint8_t * )"Connection: Close\r\n" );
-            sendb->Write( ( const uint8_t * )"Content-Length: 0\r\n\r\n" );
-            while( sendb->Length() && a_socket->Valid() )
-            {
-                a_socket->Write( sendb );
-            }
-            return 408;
-        }
         if( ( m_method == "OPTIONS" ) &&
             ( ( m_version == "HTTP/1.1" ) ||
               ( m_version == "HTTP/1.0" ) ) )
@@ -651,107 +772,118 @@ namespace utils
                  ( ( m_version == "HTTP/1.1" ) ||
                    ( m_version == "HTTP/1.0" ) ) ) )
         {
-            sendb->Write( ( const uint8_t * )"HTTP/1.1 200 OK\r\n" );
-            sendb->Write( ( const uint8_t * )"Connection: Close\r\n" );
-            sendb->Write( ( const uint8_t * )"Content-Type: text/html\r\n\r\n" );
-            while( sendb->Length() && a_socket->Valid() )
-            {
-                a_socket->Write( sendb );
-            }
-            if( m_method == "GET" )
+            ::std::shared_ptr< const DirectoryListing::Listing > listing;
+            bool listed = DirectoryListing::Shared().Get( file->Name(), listing );
+            ::std::string path = Path();
+
+            // Crawlers can ask for JSON, a page at a time, instead of HTML;
+            // through Accept only when they rank it above HTML
+            ::std::string value;
+            bool json = ( QueryValue( "format", value ) && ( value == "json" ) ) ||
+                        ( HeaderValue( "Accept", value ) &&
+                          ( HttpHelpers::AcceptQuality( value, "application/json" ) > HttpHelpers::AcceptQuality( value, "text/html" ) ) );
+            if( json )
             {
-                DIR *dir = opendir( file->Name().c_str() );
-                if( nullptr == dir )
+                size_t total  = listed? listing->Count(): 0;
+                size_t offset = 0;
+                size_t limit  = total;
+                if( QueryValue( "offset", value ) && ( value.length() > 0 ) && Tokens::IsNumber( value ) )
                 {
-                    return 200;
+                    offset = ::std::min< size_t >( strtoull( value.c_str(), nullptr, 10 ), total );
+                }
+                if( QueryValue( "limit", value ) && ( value.length() > 0 ) && Tokens::IsNumber( value ) )
+                {
+                    limit = ::std::min< size_t >( strtoull( value.c_str(), nullptr, 10 ), total );
                 }
 
-                // Enumerate the directory contents
-                struct dirent *entry;
-                std::vector< std::string > listing;
-                while( ( entry = readdir( dir ) ) != nullptr )
+                // Entries are stat'ed and sent a chunk at a time, so the
+                // length is not known up front
+                sendb->Write( ( const uint8_t * )"HTTP/1.1 200 OK\r\n" );
+                sendb->Write( ( const uint8_t * )"Connection: Close\r\n" );
+                sendb->Write( ( const uint8_t * )"Content-Type: application/json\r\n" );
+                sendb->Write( ( const uint8_t * )"Vary: Accept\r\n\r\n" );
+                while( sendb->Length() && a_socket->Valid() )
                 {
-                    std::string name = entry->d_name;
-                    // Skip symlinks
-                    if( entry->d_type == DT_LNK )
-                    {
-                        continue;
-                    }
-                    // Skip ., .., and hidden files
-                    if( entry->d_name[0] == '.' )
-                    {
-                        continue;
-                    }
-                    if( entry->d_type == DT_DIR )
+                    a_socket->Write( sendb );
+                }
+                if( m_method == "GET" )
+                {
+                    // Decoded, as in the HTML title
+                    ::std::string decoded = HttpHelpers::UriDecode( path );
+                    ::std::string chunk   = "{\"path\":\"";
+                    HttpHelpers::JsonEscape( decoded.data(), decoded.length(), chunk );
+                    snprintf( buffer, sizeof( buffer ), "\",\"total\":%zu,\"offset\":%zu,\"limit\":%zu,\"entries\":[", total, offset, limit );
+                    chunk += buffer;
+                    SendAll( *a_socket, chunk.data(), chunk.length() );
+                    bool   started = false;
+                    size_t end     = offset + ::std::min( limit, total - offset );
+                    for( size_t i = offset; ( i < end ) && a_socket->Valid(); i += LISTINGCHUNK )
                     {
-                        name += '/';
+                        chunk.clear();
+                        DirectoryListing::AppendJson( *listing, file->Name(), i, ::std::min< size_t >( LISTINGCHUNK, end - i ), started, chunk );
+                        SendAll( *a_socket, chunk.data(), chunk.length() );
                     }
-                    listing.push_back( name );
+                    SendAll( *a_socket, "\n]}\n", 4 );
                 }
-                closedir( dir );
-                entry = nullptr;
-
-                // Sort the list
-                std::sort( listing.begin(), listing.end() );
-
-                // Start the html content
-                sendb->Write( ( const uint8_t * )"<!DOCTYPE html>\n<head>\n<meta charset=\"utf-8\">\n<title>");
-                sendb->Write( ( const uint8_t * )HttpHelpers::HtmlEscape( HttpHelpers::UriDecode( m_uri ) ).c_str() );
-                // For no style, use:
-                //sendb->Write( ( const uint8_t * )"</title><meta charset=\"utf-8\"></head>\n<body>\n" );
-                sendb->Write( ( const uint8_t * )"</title>" );
-                sendb->Write( ( const uint8_t * )kDirectoryIndexCss );
-                sendb->Write( ( const uint8_t * )
-                    "</head>\n"
+                return 200;
+            }
+
+            // The page around the entries depends on the request path
+            ::std::string title = HttpHelpers::HtmlEscape( HttpHelpers::UriDecode( path ) );
+            ::std::string head  = "<!DOCTYPE html>\n<head>\n<meta charset=\"utf-8\">\n<title>";
+            head += title;
+            // For no style, use:
+            //head += "</title><meta charset=\"utf-8\"></head>\n<body>\n";
+            head += "</title>";
+            head += kDirectoryIndexCss;
+            head += "</head>\n"
                     "<body>\n"
                     "<div class=\"wrap\">\n"
-                    "<div class=\"title\">Index of " );
-                sendb->Write((const uint8_t*)
-                HttpHelpers::HtmlEscape(HttpHelpers::UriDecode(m_uri)).c_str());
-                sendb->Write((const uint8_t*)"</div>\n");
-
-                // Use the sorted directory listing to write the listing for the client
-                for( auto& name : listing )
+                    "<div class=\"title\">Index of ";
+            head += title;
+            head += "</div>\n";
+            // For no style, use:
+            //const char *tail = "</body>\n";
+            const char *tail = "</div></body>\n";
+
+            // Large listings are rendered while they are sent, so their
+            // length is not known up front
+            bool streamed = listed && listing->html.empty() && ( listing->Count() > 0 );
+            sendb->Write( ( const uint8_t * )"HTTP/1.1 200 OK\r\n" );
+            sendb->Write( ( const uint8_t * )"Connection: Close\r\n" );
+            sendb->Write( ( const uint8_t * )"Content-Type: text/html\r\n" );
+            sendb->Write( ( const uint8_t * )"Vary: Accept\r\n" );
+            if( !streamed )
+            {
+                size_t length = listed? ( head.length() + listing->html.length() + strlen( tail ) ): 0;
+                snprintf( buffer, sizeof( buffer ), "%zu", length );
+                sendb->Write( ( const uint8_t * )"Content-Length: " );
+                sendb->Write( ( const uint8_t * )buffer, strlen( buffer ) );
+                sendb->Write( ( const uint8_t * )"\r\n" );
+            }
+            sendb->Write( ( const uint8_t * )"\r\n" );
+            while( sendb->Length() && a_socket->Valid() )
+            {
+                a_socket->Write( sendb );
+            }
+            if( ( m_method == "GET" ) && listed )
+            {
+                SendAll( *a_socket, head.data(), head.length() );
+                if( streamed )
                 {
-                    if( name.empty() )
-                    {
-                        continue;
-                    }
-                    // For no style, use:
-                    //sendb->Write( ( const uint8_t * )"<a style=\"font-family: monospace;\" href=\"" );
-                    sendb->Write( ( const uint8_t * )
-                        "<div class=\"entry\">\n"
-                        "<a class=\"entry-link\" href=\"" );
-                    if( name.back() == '/' )
-                    {
-                        // URL encoding the trailing slash is ugly and breaks things
-                        sendb->Write( ( const uint8_t * )HttpHelpers::UriEncode( name.substr(0, name.size() - 1 ) ).c_str() );
-                        // The slash is needed for relative links, however
-                        sendb->Write( ( const uint8_t * )"/" );
-                    }
-                    else
-                    {
-                        sendb->Write( ( const uint8_t * )HttpHelpers::UriEncode( name ).c_str() );
-                    }
-                    sendb->Write( ( const uint8_t * )"\">");
-                    // For no style, remove this line:
-                    sendb->Write( ( const uint8_t * )"<span class=\"bullet\">• </span>" );
-                    sendb->Write( ( const uint8_t * )HttpHelpers::HtmlEscape( name ).c_str() );
-                    // For no style, use:
-                    //sendb->Write( ( const uint8_t * )"</a><br>\n" );
-                    sendb->Write( ( const uint8_t * )"</a></div>\n" );
-                    while( sendb->Length() && a_socket->Valid() )
+                    ::std::string chunk;
+                    for( size_t i = 0; ( i < listing->Count() ) && a_socket->Valid(); i += LISTINGCHUNK )
                     {
-                        a_socket->Write( sendb );
+                        chunk.clear();
+                        DirectoryListing::AppendHtml( *listing, i, LISTINGCHUNK, chunk );
+                        SendAll( *a_socket, chunk.data(), chunk.length() );
                     }
                 }
-                // For no style, use:
-                //sendb->Write( ( const uint8_t * )"</body>\n" );
-                sendb->Write( ( const uint8_t * )"</div></body>\n" );
-                while( sendb->Length() && a_socket->Valid() )
+                else
                 {
-                    a_socket->Write( sendb );
+                    SendAll( *a_socket, listing->html.data(), listing->html.length() );
                 }
+                SendAll( *a_socket, tail, strlen( tail ) );
             }
             return 200;
         }
@@ -774,7 +906,7 @@ namespace utils
         utils::Lock lock( this );
         utils::Lock valueLock( &a_logger );
         char port[ 32 ];
-        ::std::shared_ptr< KeyValuePair< ::std::string, ::std::string > > start = m_meta;
+        ::std::shared_ptr< Header > start = m_meta;
 
         snprintf( port, sizeof( port ), "%u", m_port );
         a_logger.Log( m_addr, true, false );
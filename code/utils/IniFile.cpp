@@ -16,35 +16,30 @@ namespace utils
 
     IniFileHeading::~IniFileHeading()
     {
-        ::utils::Lock lock( this );
     }
 
     ::std::string &IniFileHeading::Name()
     {
-        ::utils::Lock lock( this );
         return m_name;
     }
 
     ::std::shared_ptr< IniFileHeading > &IniFileHeading::Next()
     {
-        ::utils::Lock lock( this );
         return m_next;
     }
 
-    ::std::shared_ptr< KeyValuePair< ::std::string, ::std::string > > &IniFileHeading::Entries()
+    ::std::shared_ptr< IniFileEntry > &IniFileHeading::Entries()
     {
-        ::utils::Lock lock( this );
         return m_entries;
     }
 
     bool IniFileHeading::SetValue( const char *a_key, const char *a_value )
     {
-        ::utils::Lock lock( this );
         if( ( nullptr == a_key ) || ( nullptr == a_value ) )
         {
             return false;
         }
-        ::std::shared_ptr< KeyValuePair< ::std::string, ::std::string > > entry = ::std::make_shared< KeyValuePair< ::std::string, ::std::string > >();
+        ::std::shared_ptr< IniFileEntry > entry = ::std::make_shared< IniFileEntry >();
         if( entry )
         {
             entry->Key() = a_key;
@@ -57,7 +52,7 @@ namespace utils
             }
             else
             {
-                ::std::shared_ptr< KeyValuePair< ::std::string, ::std::string > > start = m_entries;
+                ::std::shared_ptr< IniFileEntry > start = m_entries;
                 while( start && ( start->Key() != entry->Key() ) )
                 {
                     if( !start->Next() )
@@ -79,7 +74,6 @@ namespace utils
 
     bool IniFileHeading::GetValue( const char *a_key, ::std::string &a_value )
     {
-        ::utils::Lock lock( this );
         if( ( nullptr == a_key ) || !m_entries )
         {
             return false;
@@ -90,7 +84,7 @@ namespace utils
             return false;
         }
         Tokens::MakeUpper( key );
-        ::std::shared_ptr< KeyValuePair< ::std::string, ::std::string > > entries = m_entries;
+        ::std::shared_ptr< IniFileEntry > entries = m_entries;
         while( entries )
         {
             if( entries->Key() == key )
@@ -106,8 +100,10 @@ namespace utils
     IniFile::IniFile( const char *a_file )
     : m_file( a_file, FileMode::DefaultRead )
     , m_modTime( 0 )
-    , m_loading( false )
     {
+        ::utils::Lock lock( this );
+        // Without a watch, ReadValue falls back to a stat per call
+        m_file.Watch();
         LoadFile();
     }
 
@@ -119,11 +115,9 @@ namespace utils
 
     void IniFile::LoadFile()
     {
-        ::utils::Lock lock( this );
         ::utils::Lock fileLock( &m_file );
         ::std::string heading;
         ::std::shared_ptr< Buffer > buffer = ::std::make_shared< Buffer >( 4096 );
-        m_loading = true;
         m_modTime = m_file.ModificationTime();
         m_heading = nullptr;
         m_file.Seek( 0 );
@@ -184,23 +178,18 @@ namespace utils
                 }
                 if( ( heading.length() > 0 ) && ( key.length() > 0 ) && ( value.length() > 0 ) )
                 {
+                    bool changed = false;
                     Tokens::MakeUpper( key );
-                    WriteValue( heading.c_str(), key.c_str(), value.c_str() );
+                    Store( heading.c_str(), key.c_str(), value.c_str(), changed );
                 }
             }
         }
         m_file.Close();
-        m_loading = false;
     }
 
     void IniFile::SaveFile()
     {
-        ::utils::Lock lock( this );
         ::utils::Lock fileLock( &m_file );
-        if( m_loading )
-        {
-            return;
-        }
         if( m_heading )
         {
             m_file.Seek( 0 );
@@ -211,7 +200,7 @@ namespace utils
                 m_file.Write( ( const uint8_t * )"[", 1 );
                 m_file.Write( ( const uint8_t * )start->Name().c_str(), start->Name().length() );
                 m_file.Write( ( const uint8_t * )"]\n", 2 );
-                ::std::shared_ptr< KeyValuePair< ::std::string, ::std::string > > entries = start->Entries();
+                ::std::shared_ptr< IniFileEntry > entries = start->Entries();
                 while( entries )
                 {
                     m_file.Write( ( const uint8_t * )entries->Key().c_str(), entries->Key().length() );
@@ -229,93 +218,118 @@ namespace utils
         }
     }
 
-    bool IniFile::ReadValue( const char *a_heading, const char *a_name, ::std::string &a_value )
+    bool IniFile::Find( const char *a_heading, const char *a_name, ::std::string &a_value )
     {
-        ::utils::Lock lock( this );
-        if( m_file.ModificationTime() != m_modTime )
+        if( ( nullptr == a_heading ) || !m_heading )
         {
-            LoadFile();
+            return false;
         }
-        if( m_heading )
+        ::std::string heading( a_heading );
+        if( heading.length() == 0 )
         {
-            ::std::string heading( a_heading );
-            if( heading.length() == 0 )
-            {
-                return false;
-            }
-            Tokens::MakeUpper( heading );
-            ::std::shared_ptr< IniFileHeading > start = m_heading;
-            while( start && ( start->Name() != heading ) )
-            {
-                start = start->Next();
-            }
-            if( start )
-            {
-                return start->GetValue( a_name, a_value );
-            }
+            return false;
+        }
+        Tokens::MakeUpper( heading );
+        ::std::shared_ptr< IniFileHeading > start = m_heading;
+        while( start && ( start->Name() != heading ) )
+        {
+            start = start->Next();
+        }
+        if( start )
+        {
+            return start->GetValue( a_name, a_value );
         }
         return false;
     }
 
-    bool IniFile::WriteValue( const char *a_heading, const char *a_name, const char *a_value )
+    bool IniFile::Store( const char *a_heading, const char *a_name, const char *a_value, bool &a_changed )
     {
-        ::utils::Lock lock( this );
+        a_changed = false;
+        if( ( nullptr == a_heading ) || ( nullptr == a_name ) || ( nullptr == a_value ) )
+        {
+            return false;
+        }
+        ::std::string heading( a_heading );
+        Tokens::MakeUpper( heading );
         if( !m_heading )
         {
-            m_heading = ::std::make_shared< IniFileHeading >();
-            if( m_heading )
+            ::std::shared_ptr< IniFileHeading > created = ::std::make_shared< IniFileHeading >();
+            if( !created )
             {
-                m_heading->Name() = a_heading;
-                Tokens::MakeUpper( m_heading->Name() );
-                if( !m_heading->SetValue( a_name, a_value ) )
-                {
-                    m_heading = nullptr;
-                }
-                else
-                {
-                    SaveFile();
-                }
-                return m_heading.get();
+                return false;
+            }
+            created->Name() = heading;
+            if( !created->SetValue( a_name, a_value ) )
+            {
+                return false;
             }
+            m_heading = created;
+            a_changed = true;
+            return true;
         }
-        else
+        bool updated = false;
+        ::std::shared_ptr< IniFileHeading > start = m_heading;
+        while( start && ( start->Name() != heading ) )
         {
-            bool updated = false;
-            ::std::shared_ptr< IniFileHeading > start = m_heading;
-            while( start && ( start->Name() != a_heading ) )
+            if( !start->Next() )
             {
-                if( !start->Next() )
+                start->Next() = ::std::make_shared< IniFileHeading >();
+                if( start->Next() )
                 {
-                    start->Next() = ::std::make_shared< IniFileHeading >();
-                    if( start->Next() )
-                    {
-                        start->Next()->Name() = a_heading;
-                        updated = true;
-                    }
+                    start->Next()->Name() = heading;
+                    updated = true;
                 }
-                start = start->Next();
             }
-            if( start )
+            start = start->Next();
+        }
+        if( start )
+        {
+            ::std::string value;
+            if( !updated && start->GetValue( a_name, value ) && ( value == a_value ) )
             {
-                ::std::string value;
-                if( !updated )
-                {
-                    if( start->GetValue( a_name, value ) )
-                    {
-                        if( value == a_value )
-                        {
-                            return true;
-                        }
-                    }
-                    updated = true;
-                }
-                if( updated && start->SetValue( a_name, a_value ) )
-                {
-                    SaveFile();
-                    return true;
-                }
+                return true;
+            }
+            if( start->SetValue( a_name, a_value ) )
+            {
+                a_changed = true;
+                return true;
             }
         }
         return false;
     }
+
+    bool IniFile::ReadValue( const char *a_heading, const char *a_name, ::std::string &a_value )
+    {
+        uint32_t modTime = m_file.ModificationTime();
+        {
+            ::utils::SharedLock lock( this );
+            if( modTime == m_modTime )
+            {
+                return Find( a_heading, a_name, a_value );
+            }
+        }
+        // The file changed on disk; reload under the exclusive lock unless
+        // another reader already did.
+        ::utils::Lock lock( this );
+        if( m_file.ModificationTime() != m_modTime )
+        {
+            LoadFile();
+        }
+        return Find( a_heading, a_name, a_value );
+    }
+
+    bool IniFile::WriteValue( const char *a_heading, const char *a_name, const char *a_value )
+    {
+        ::utils::Lock lock( this );
+        bool changed = false;
+        if( !Store( a_heading, a_name, a_value, changed ) )
+        {
+            return false;
+        }
+        if( changed )
+        {
+            SaveFile();
+        }
+        return true;
+    }
 }
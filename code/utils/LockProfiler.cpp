@@ -0,0 +1,223 @@
+/**
+    LockProfiler.cpp : LockProfiler implementation
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#include <utils/LockProfiler.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cxxabi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LOCKPROFILER_SITES 1024 // Must be a power of two
+
+namespace utils
+{
+    struct LockProfilerSlot
+    {
+        ::std::atomic< uint64_t >    key;
+        ::std::atomic< bool >        ready;
+        const char                  *type;
+        const char                  *file;
+        const char                  *function;
+        uint32_t                     line;
+        bool                         shared;
+        ::std::atomic< uint64_t >    count;
+        ::std::atomic< uint64_t >    waitNs;
+        ::std::atomic< uint64_t >    maxWaitNs;
+        ::std::atomic< uint64_t >    holdNs;
+        ::std::atomic< uint64_t >    maxHoldNs;
+    };
+
+    static LockProfilerSlot s_sites[ LOCKPROFILER_SITES ];
+
+    static void UpdateMax( ::std::atomic< uint64_t > &a_max, uint64_t a_value )
+    {
+        uint64_t current = a_max.load( ::std::memory_order_relaxed );
+        while( ( a_value > current ) &&
+              !a_max.compare_exchange_weak( current, a_value, ::std::memory_order_relaxed ) )
+        {
+        }
+    }
+
+    uint32_t LockProfiler::Register( const char *a_type, const ::std::source_location &a_location, bool a_shared )
+    {
+        // Type names and file names are string literals, so their addresses
+        // identify them; mix them with the line and mode into a key.
+        uint64_t key = reinterpret_cast< uintptr_t >( a_type );
+        key = ( key * 0x9E3779B97F4A7C15ULL ) ^ reinterpret_cast< uintptr_t >( a_location.file_name() );
+        key = ( key * 0x9E3779B97F4A7C15ULL ) ^ ( ( static_cast< uint64_t >( a_location.line() ) << 1 ) | ( a_shared ? 1 : 0 ) );
+        key = ( key ^ ( key >> 29 ) ) | 1;
+
+        uint32_t index = static_cast< uint32_t >( key ) & ( LOCKPROFILER_SITES - 1 );
+        for( uint32_t probe = 0; probe < LOCKPROFILER_SITES; ++probe )
+        {
+            LockProfilerSlot &slot = s_sites[ index ];
+            uint64_t current = slot.key.load( ::std::memory_order_acquire );
+            if( current == key )
+            {
+                return index;
+            }
+            if( 0 == current )
+            {
+                if( slot.key.compare_exchange_strong( current, key, ::std::memory_order_acq_rel ) )
+                {
+                    slot.type     = a_type;
+                    slot.file     = a_location.file_name();
+                    slot.function = a_location.function_name();
+                    slot.line     = a_location.line();
+                    slot.shared   = a_shared;
+                    slot.ready.store( true, ::std::memory_order_release );
+                    return index;
+                }
+                if( current == key )
+                {
+                    return index;
+                }
+            }
+            index = ( index + 1 ) & ( LOCKPROFILER_SITES - 1 );
+        }
+        return InvalidSite;
+    }
+
+    void LockProfiler::Acquired( uint32_t a_site, uint64_t a_waitNs )
+    {
+        if( a_site >= LOCKPROFILER_SITES )
+        {
+            return;
+        }
+        LockProfilerSlot &slot = s_sites[ a_site ];
+        slot.count.fetch_add( 1, ::std::memory_order_relaxed );
+        slot.waitNs.fetch_add( a_waitNs, ::std::memory_order_relaxed );
+        UpdateMax( slot.maxWaitNs, a_waitNs );
+    }
+
+    void LockProfiler::Released( uint32_t a_site, uint64_t a_holdNs )
+    {
+        if( a_site >= LOCKPROFILER_SITES )
+        {
+            return;
+        }
+        LockProfilerSlot &slot = s_sites[ a_site ];
+        slot.holdNs.fetch_add( a_holdNs, ::std::memory_order_relaxed );
+        UpdateMax( slot.maxHoldNs, a_holdNs );
+    }
+
+    uint64_t LockProfiler::Now()
+    {
+        struct timespec now;
+        clock_gettime( CLOCK_MONOTONIC, &now );
+        return ( static_cast< uint64_t >( now.tv_sec ) * 1000000000ULL ) + static_cast< uint64_t >( now.tv_nsec );
+    }
+
+    void LockProfiler::Snapshot( ::std::vector< Site > &a_sites )
+    {
+        a_sites.clear();
+        for( uint32_t i = 0; i < LOCKPROFILER_SITES; ++i )
+        {
+            LockProfilerSlot &slot = s_sites[ i ];
+            if( !slot.ready.load( ::std::memory_order_acquire ) )
+            {
+                continue;
+            }
+            // Inline code locking from several translation units registers
+            // one slot per unit; fold those into a single site.
+            Site *existing = nullptr;
+            for( auto &site : a_sites )
+            {
+                if( ( site.line == slot.line ) && ( site.shared == slot.shared ) &&
+                    ( 0 == strcmp( site.file, slot.file ) ) && ( 0 == strcmp( site.type, slot.type ) ) )
+                {
+                    existing = &site;
+                    break;
+                }
+            }
+            if( nullptr != existing )
+            {
+                existing->count     += slot.count.load( ::std::memory_order_relaxed );
+                existing->waitNs    += slot.waitNs.load( ::std::memory_order_relaxed );
+                existing->maxWaitNs  = ::std::max( existing->maxWaitNs, slot.maxWaitNs.load( ::std::memory_order_relaxed ) );
+                existing->holdNs    += slot.holdNs.load( ::std::memory_order_relaxed );
+                existing->maxHoldNs  = ::std::max( existing->maxHoldNs, slot.maxHoldNs.load( ::std::memory_order_relaxed ) );
+                continue;
+            }
+            Site site;
+            site.type      = slot.type;
+            site.file      = slot.file;
+            site.function  = slot.function;
+            site.line      = slot.line;
+            site.shared    = slot.shared;
+            site.count     = slot.count.load( ::std::memory_order_relaxed );
+            site.waitNs    = slot.waitNs.load( ::std::memory_order_relaxed );
+            site.maxWaitNs = slot.maxWaitNs.load( ::std::memory_order_relaxed );
+            site.holdNs    = slot.holdNs.load( ::std::memory_order_relaxed );
+            site.maxHoldNs = slot.maxHoldNs.load( ::std::memory_order_relaxed );
+            a_sites.push_back( site );
+        }
+    }
+
+    void LockProfiler::Report( ::std::string &a_output )
+    {
+        if( !Enabled() )
+        {
+            a_output += "Lock profiling disabled (build with LOCKPROFILE=1)\n";
+            return;
+        }
+
+        ::std::vector< Site > sites;
+        Snapshot( sites );
+        ::std::sort( sites.begin(), sites.end(), []( const Site &a_left, const Site &a_right )
+        {
+            return a_left.waitNs > a_right.waitNs;
+        } );
+
+        char line[ 256 ];
+        snprintf( line, sizeof( line ), "%-12s %-12s %-12s %-12s %-12s %-6s %s\n",
+            "count", "wait_ns", "max_wait_ns", "hold_ns", "max_hold_ns", "mode", "type @ site" );
+        a_output += line;
+        for( const auto &site : sites )
+        {
+            if( 0 == site.count )
+            {
+                continue;
+            }
+            snprintf( line, sizeof( line ), "%-12llu %-12llu %-12llu %-12llu %-12llu %-6s ",
+                static_cast< unsigned long long >( site.count ),
+                static_cast< unsigned long long >( site.waitNs ),
+                static_cast< unsigned long long >( site.maxWaitNs ),
+                static_cast< unsigned long long >( site.holdNs ),
+                static_cast< unsigned long long >( site.maxHoldNs ),
+                site.shared ? "shared" : "excl" );
+            a_output += line;
+
+            int status = 0;
+            char *demangled = abi::__cxa_demangle( site.type, nullptr, nullptr, &status );
+            a_output += ( ( 0 == status ) && demangled ) ? demangled : site.type;
+            free( demangled );
+            a_output += " @ ";
+            a_output += site.function;
+            a_output += " (";
+            a_output += site.file;
+            a_output += ":";
+            a_output += ::std::to_string( site.line );
+            a_output += ")\n";
+        }
+    }
+
+    void LockProfiler::Reset()
+    {
+        for( uint32_t i = 0; i < LOCKPROFILER_SITES; ++i )
+        {
+            LockProfilerSlot &slot = s_sites[ i ];
+            slot.count.store( 0, ::std::memory_order_relaxed );
+            slot.waitNs.store( 0, ::std::memory_order_relaxed );
+            slot.maxWaitNs.store( 0, ::std::memory_order_relaxed );
+            slot.holdNs.store( 0, ::std::memory_order_relaxed );
+            slot.maxHoldNs.store( 0, ::std::memory_order_relaxed );
+        }
+    }
+}
@@ -0,0 +1,164 @@
+/**
+    RateLimiter.cpp : RateLimiter implementation
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#include <utils/RateLimiter.hpp>
+#include <utils/Lock.hpp>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+
+#define RATELIMITER_SHARDS 16 // Independently locked parts of the table
+#define RATELIMITER_PROBES 16 // Slots searched for a client before giving up
+
+namespace utils
+{
+    RateLimiter::RateLimiter( double a_rate, double a_burst, uint32_t a_connections, uint32_t a_capacity /*= 4096*/ )
+    : m_shards( new Shard[ RATELIMITER_SHARDS ] )
+    , m_shardCount( RATELIMITER_SHARDS )
+    , m_mask( 0 )
+    , m_rate( ::std::max( 0.0, a_rate ) / 1000.0 )
+    , m_burst( ::std::max( 1.0, a_burst ) )
+    , m_connections( a_connections )
+    {
+        uint32_t size = ::std::bit_ceil( ::std::max< uint32_t >( RATELIMITER_PROBES, a_capacity / m_shardCount ) );
+        m_mask = size - 1;
+        for( uint32_t s = 0; s < m_shardCount; ++s )
+        {
+            m_shards[ s ].entries.resize( size );
+        }
+    }
+
+    uint64_t RateLimiter::Hash( const ::std::string &a_client )
+    {
+        // FNV-1a with a final mix so both the shard and slot bits vary
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        for( unsigned char c : a_client )
+        {
+            hash ^= c;
+            hash *= 0x100000001B3ULL;
+        }
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 33;
+        return ( 0 == hash )? 1: hash;
+    }
+
+    uint64_t RateLimiter::Now()
+    {
+        auto now = ::std::chrono::steady_clock::now().time_since_epoch();
+        return static_cast< uint64_t >( ::std::chrono::duration_cast< ::std::chrono::milliseconds >( now ).count() );
+    }
+
+    void RateLimiter::Refill( Entry &a_entry, uint64_t a_now ) const
+    {
+        if( a_now > a_entry.stamp )
+        {
+            double tokens = a_entry.tokens + ( static_cast< double >( a_now - a_entry.stamp ) * m_rate );
+            a_entry.tokens = static_cast< float >( ::std::min( m_burst, tokens ) );
+            a_entry.stamp  = a_now;
+        }
+    }
+
+    RateLimiter::Entry *RateLimiter::Find( Shard &a_shard, uint64_t a_key, uint64_t a_now, bool a_create )
+    {
+        Entry   *reuse = nullptr;
+        uint32_t slot  = static_cast< uint32_t >( a_key ) & m_mask;
+        for( uint32_t p = 0; p < RATELIMITER_PROBES; ++p )
+        {
+            Entry &entry = a_shard.entries[ ( slot + p ) & m_mask ];
+            if( entry.key == a_key )
+            {
+                return &entry;
+            }
+            if( 0 == entry.key )
+            {
+                // Slots are never emptied, so the key is not further along
+                reuse = reuse? reuse: &entry;
+                break;
+            }
+            if( !reuse && ( 0 == entry.connections ) )
+            {
+                // Aged out once its bucket has refilled
+                Refill( entry, a_now );
+                if( ( 0 == m_rate ) || ( entry.tokens >= m_burst ) )
+                {
+                    reuse = &entry;
+                }
+            }
+        }
+        if( !a_create || !reuse )
+        {
+            return nullptr;
+        }
+        reuse->key         = a_key;
+        reuse->stamp       = a_now;
+        reuse->tokens      = static_cast< float >( m_burst );
+        reuse->connections = 0;
+        return reuse;
+    }
+
+    bool RateLimiter::Connect( const ::std::string &a_client )
+    {
+        if( 0 == m_connections )
+        {
+            return true;
+        }
+        uint64_t key   = Hash( a_client );
+        Shard   &shard = m_shards[ ( key >> 32 ) % m_shardCount ];
+        ::utils::Lock lock( &shard );
+        Entry *entry = Find( shard, key, Now(), true );
+        if( !entry )
+        {
+            return true;
+        }
+        if( entry->connections >= m_connections )
+        {
+            return false;
+        }
+        ++( entry->connections );
+        return true;
+    }
+
+    void RateLimiter::Disconnect( const ::std::string &a_client )
+    {
+        if( 0 == m_connections )
+        {
+            return;
+        }
+        uint64_t key   = Hash( a_client );
+        Shard   &shard = m_shards[ ( key >> 32 ) % m_shardCount ];
+        ::utils::Lock lock( &shard );
+        Entry *entry = Find( shard, key, Now(), false );
+        if( entry && ( entry->connections > 0 ) )
+        {
+            --( entry->connections );
+        }
+    }
+
+    bool RateLimiter::Request( const ::std::string &a_client )
+    {
+        if( 0 == m_rate )
+        {
+            return true;
+        }
+        uint64_t key   = Hash( a_client );
+        uint64_t now   = Now();
+        Shard   &shard = m_shards[ ( key >> 32 ) % m_shardCount ];
+        ::utils::Lock lock( &shard );
+        Entry *entry = Find( shard, key, now, true );
+        if( !entry )
+        {
+            return true;
+        }
+        Refill( *entry, now );
+        if( entry->tokens < 1.0f )
+        {
+            return false;
+        }
+        entry->tokens -= 1.0f;
+        return true;
+    }
+}
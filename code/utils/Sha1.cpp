@@ -0,0 +1,297 @@
+/**
+    Sha1.cpp : Sha1 implementation
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#include <utils/Sha1.hpp>
+#include <algorithm>
+#include <bit>
+#include <string.h>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define SHA1_X86
+#endif
+
+namespace utils
+{
+    typedef void ( *Sha1Compress )( uint32_t a_state[ 5 ], const uint8_t *a_blocks, size_t a_count );
+
+    static inline uint32_t LoadBigEndian( const uint8_t *a_data )
+    {
+        return ( static_cast< uint32_t >( a_data[ 0 ] ) << 24 ) |
+               ( static_cast< uint32_t >( a_data[ 1 ] ) << 16 ) |
+               ( static_cast< uint32_t >( a_data[ 2 ] ) << 8 ) |
+               ( static_cast< uint32_t >( a_data[ 3 ] ) );
+    }
+
+    static void CompressPortable( uint32_t a_state[ 5 ], const uint8_t *a_blocks, size_t a_count )
+    {
+        for( ; a_count > 0; --a_count, a_blocks += 64 )
+        {
+            // The schedule is kept as a 16-word ring rather than all 80 words
+            uint32_t w[ 16 ];
+            for( uint32_t i = 0; i < 16; ++i )
+            {
+                w[ i ] = LoadBigEndian( a_blocks + ( i * 4 ) );
+            }
+
+            uint32_t a = a_state[ 0 ];
+            uint32_t b = a_state[ 1 ];
+            uint32_t c = a_state[ 2 ];
+            uint32_t d = a_state[ 3 ];
+            uint32_t e = a_state[ 4 ];
+
+            auto round = [ & ]( uint32_t a_index, uint32_t a_f, uint32_t a_k )
+            {
+                uint32_t word = w[ a_index & 15 ];
+                if( a_index >= 16 )
+                {
+                    word = ::std::rotl( w[ ( a_index - 3 ) & 15 ] ^ w[ ( a_index - 8 ) & 15 ] ^
+                                        w[ ( a_index - 14 ) & 15 ] ^ w[ a_index & 15 ], 1 );
+                    w[ a_index & 15 ] = word;
+                }
+                uint32_t temp = ::std::rotl( a, 5 ) + a_f + e + a_k + word;
+                e = d;
+                d = c;
+                c = ::std::rotl( b, 30 );
+                b = a;
+                a = temp;
+            };
+
+            for( uint32_t i = 0; i < 20; ++i )
+            {
+                round( i, d ^ ( b & ( c ^ d ) ), 0x5A827999 );
+            }
+            for( uint32_t i = 20; i < 40; ++i )
+            {
+                round( i, b ^ c ^ d, 0x6ED9EBA1 );
+            }
+            for( uint32_t i = 40; i < 60; ++i )
+            {
+                round( i, ( b & c ) | ( d & ( b | c ) ), 0x8F1BBCDC );
+            }
+            for( uint32_t i = 60; i < 80; ++i )
+            {
+                round( i, b ^ c ^ d, 0xCA62C1D6 );
+            }
+
+            a_state[ 0 ] += a;
+            a_state[ 1 ] += b;
+            a_state[ 2 ] += c;
+            a_state[ 3 ] += d;
+            a_state[ 4 ] += e;
+        }
+    }
+
+#ifdef SHA1_X86
+    // Four rounds once the message schedule is running: fold the next words
+    // into E, run the rounds, and advance the schedule with the same words
+    #define SHA1NI_ROUNDS( e_use, e_next, func, msg, msg2, msg1, msgx ) \
+        e_use  = _mm_sha1nexte_epu32( e_use, msg );                     \
+        e_next = abcd;                                                  \
+        msg2   = _mm_sha1msg2_epu32( msg2, msg );                       \
+        abcd   = _mm_sha1rnds4_epu32( abcd, e_use, func );              \
+        msg1   = _mm_sha1msg1_epu32( msg1, msg );                       \
+        msgx   = _mm_xor_si128( msgx, msg );
+
+    __attribute__(( target( "sha,sse4.1" ) ))
+    static void CompressShaNi( uint32_t a_state[ 5 ], const uint8_t *a_blocks, size_t a_count )
+    {
+        const __m128i mask = _mm_set_epi64x( 0x0001020304050607ULL, 0x08090A0B0C0D0E0FULL );
+
+        __m128i abcd = _mm_shuffle_epi32( _mm_loadu_si128( reinterpret_cast< const __m128i * >( a_state ) ), 0x1B );
+        __m128i e0   = _mm_set_epi32( static_cast< int32_t >( a_state[ 4 ] ), 0, 0, 0 );
+        __m128i e1;
+        __m128i msg0;
+        __m128i msg1;
+        __m128i msg2;
+        __m128i msg3;
+
+        for( ; a_count > 0; --a_count, a_blocks += 64 )
+        {
+            __m128i abcdSave = abcd;
+            __m128i e0Save   = e0;
+
+            // Rounds 0-15 load the block
+            msg0 = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast< const __m128i * >( a_blocks ) ), mask );
+            e0   = _mm_add_epi32( e0, msg0 );
+            e1   = abcd;
+            abcd = _mm_sha1rnds4_epu32( abcd, e0, 0 );
+
+            msg1 = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast< const __m128i * >( a_blocks + 16 ) ), mask );
+            e1   = _mm_sha1nexte_epu32( e1, msg1 );
+            e0   = abcd;
+            abcd = _mm_sha1rnds4_epu32( abcd, e1, 0 );
+            msg0 = _mm_sha1msg1_epu32( msg0, msg1 );
+
+            msg2 = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast< const __m128i * >( a_blocks + 32 ) ), mask );
+            e0   = _mm_sha1nexte_epu32( e0, msg2 );
+            e1   = abcd;
+            abcd = _mm_sha1rnds4_epu32( abcd, e0, 0 );
+            msg1 = _mm_sha1msg1_epu32( msg1, msg2 );
+            msg0 = _mm_xor_si128( msg0, msg2 );
+
+            msg3 = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast< const __m128i * >( a_blocks + 48 ) ), mask );
+            e1   = _mm_sha1nexte_epu32( e1, msg3 );
+            e0   = abcd;
+            msg0 = _mm_sha1msg2_epu32( msg0, msg3 );
+            abcd = _mm_sha1rnds4_epu32( abcd, e1, 0 );
+            msg2 = _mm_sha1msg1_epu32( msg2, msg3 );
+            msg1 = _mm_xor_si128( msg1, msg3 );
+
+            // Rounds 16-67
+            SHA1NI_ROUNDS( e0, e1, 0, msg0, msg1, msg3, msg2 )
+            SHA1NI_ROUNDS( e1, e0, 1, msg1, msg2, msg0, msg3 )
+            SHA1NI_ROUNDS( e0, e1, 1, msg2, msg3, msg1, msg0 )
+            SHA1NI_ROUNDS( e1, e0, 1, msg3, msg0, msg2, msg1 )
+            SHA1NI_ROUNDS( e0, e1, 1, msg0, msg1, msg3, msg2 )
+            SHA1NI_ROUNDS( e1, e0, 1, msg1, msg2, msg0, msg3 )
+            SHA1NI_ROUNDS( e0, e1, 2, msg2, msg3, msg1, msg0 )
+            SHA1NI_ROUNDS( e1, e0, 2, msg3, msg0, msg2, msg1 )
+            SHA1NI_ROUNDS( e0, e1, 2, msg0, msg1, msg3, msg2 )
+            SHA1NI_ROUNDS( e1, e0, 2, msg1, msg2, msg0, msg3 )
+            SHA1NI_ROUNDS( e0, e1, 2, msg2, msg3, msg1, msg0 )
+            SHA1NI_ROUNDS( e1, e0, 3, msg3, msg0, msg2, msg1 )
+            SHA1NI_ROUNDS( e0, e1, 3, msg0, msg1, msg3, msg2 )
+
+            // Rounds 68-79 drain the schedule
+            e1   = _mm_sha1nexte_epu32( e1, msg1 );
+            e0   = abcd;
+            msg2 = _mm_sha1msg2_epu32( msg2, msg1 );
+            abcd = _mm_sha1rnds4_epu32( abcd, e1, 3 );
+            msg3 = _mm_xor_si128( msg3, msg1 );
+
+            e0   = _mm_sha1nexte_epu32( e0, msg2 );
+            e1   = abcd;
+            msg3 = _mm_sha1msg2_epu32( msg3, msg2 );
+            abcd = _mm_sha1rnds4_epu32( abcd, e0, 3 );
+
+            e1   = _mm_sha1nexte_epu32( e1, msg3 );
+            e0   = abcd;
+            abcd = _mm_sha1rnds4_epu32( abcd, e1, 3 );
+
+            e0   = _mm_sha1nexte_epu32( e0, e0Save );
+            abcd = _mm_add_epi32( abcd, abcdSave );
+        }
+
+        _mm_storeu_si128( reinterpret_cast< __m128i * >( a_state ), _mm_shuffle_epi32( abcd, 0x1B ) );
+        a_state[ 4 ] = static_cast< uint32_t >( _mm_extract_epi32( e0, 3 ) );
+    }
+
+    #undef SHA1NI_ROUNDS
+#endif
+
+    static Sha1Compress SelectCompress()
+    {
+#ifdef SHA1_X86
+        __builtin_cpu_init();
+        if( __builtin_cpu_supports( "sha" ) && __builtin_cpu_supports( "sse4.1" ) )
+        {
+            return CompressShaNi;
+        }
+#endif
+        return CompressPortable;
+    }
+
+    static const Sha1Compress s_compress = SelectCompress();
+
+    Sha1::Sha1()
+    {
+        Reset();
+    }
+
+    void Sha1::Reset()
+    {
+        m_state[ 0 ] = 0x67452301;
+        m_state[ 1 ] = 0xEFCDAB89;
+        m_state[ 2 ] = 0x98BADCFE;
+        m_state[ 3 ] = 0x10325476;
+        m_state[ 4 ] = 0xC3D2E1F0;
+        m_length     = 0;
+        m_used       = 0;
+    }
+
+    void Sha1::Compress( uint32_t a_state[ 5 ], const uint8_t *a_blocks, size_t a_count )
+    {
+        // Static objects in other translation units may hash before
+        // s_compress is initialized
+        Sha1Compress compress = s_compress? s_compress: SelectCompress();
+        compress( a_state, a_blocks, a_count );
+    }
+
+    void Sha1::Update( const uint8_t *a_data, size_t a_len )
+    {
+        m_length += a_len;
+        if( m_used > 0 )
+        {
+            size_t take = ::std::min< size_t >( a_len, sizeof( m_block ) - m_used );
+            memcpy( m_block + m_used, a_data, take );
+            m_used += static_cast< uint32_t >( take );
+            a_data += take;
+            a_len  -= take;
+            if( m_used < sizeof( m_block ) )
+            {
+                return;
+            }
+            Compress( m_state, m_block, 1 );
+            m_used = 0;
+        }
+        if( a_len >= sizeof( m_block ) )
+        {
+            size_t blocks = a_len / sizeof( m_block );
+            Compress( m_state, a_data, blocks );
+            a_data += blocks * sizeof( m_block );
+            a_len  -= blocks * sizeof( m_block );
+        }
+        if( a_len > 0 )
+        {
+            memcpy( m_block, a_data, a_len );
+            m_used = static_cast< uint32_t >( a_len );
+        }
+    }
+
+    void Sha1::Final( uint8_t a_digest[ DIGESTLEN ] )
+    {
+        uint64_t bits = m_length * 8;
+        m_block[ m_used++ ] = 0x80;
+        if( m_used > 56 )
+        {
+            memset( m_block + m_used, 0, sizeof( m_block ) - m_used );
+            Compress( m_state, m_block, 1 );
+            m_used = 0;
+        }
+        memset( m_block + m_used, 0, 56 - m_used );
+        for( uint32_t i = 0; i < 8; ++i )
+        {
+            m_block[ 56 + i ] = static_cast< uint8_t >( bits >> ( 56 - ( i * 8 ) ) );
+        }
+        Compress( m_state, m_block, 1 );
+        m_used = 0;
+
+        for( uint32_t i = 0; i < 5; ++i )
+        {
+            a_digest[ ( i * 4 ) ]     = static_cast< uint8_t >( m_state[ i ] >> 24 );
+            a_digest[ ( i * 4 ) + 1 ] = static_cast< uint8_t >( m_state[ i ] >> 16 );
+            a_digest[ ( i * 4 ) + 2 ] = static_cast< uint8_t >( m_state[ i ] >> 8 );
+            a_digest[ ( i * 4 ) + 3 ] = static_cast< uint8_t >( m_state[ i ] );
+        }
+    }
+
+    void Sha1::Hash( const uint8_t *a_data, size_t a_len, uint8_t a_digest[ DIGESTLEN ] )
+    {
+        Sha1 sha;
+        sha.Update( a_data, a_len );
+        sha.Final( a_digest );
+    }
+
+    bool Sha1::Accelerated()
+    {
+#ifdef SHA1_X86
+        return ( SelectCompress() != CompressPortable );
+#else
+        return false;
+#endif
+    }
+}
@@ -7,6 +7,7 @@
 #include <utils/Socket.hpp>
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <netinet/tcp.h>
 #include <sys/poll.h>
 #include <fcntl.h>
 #include <errno.h>
@@ -21,22 +22,32 @@
 
 namespace utils
 {
+    static bool WouldBlock( int32_t a_error )
+    {
+        return ( EAGAIN == a_error ) || ( EWOULDBLOCK == a_error );
+    }
+
     Socket::Socket( int32_t a_sockfd, uint32_t a_flags /*= 0*/ )
-    : m_sockfd  ( a_sockfd )
-    , m_valid   ( a_sockfd >= 0 )
-    , m_error   ( 0 )
-    , m_flags   ( a_flags )
+    : m_sockfd    ( a_sockfd )
+    , m_valid     ( a_sockfd >= 0 )
+    , m_error     ( 0 )
+    , m_flags     ( a_flags )
+    , m_peer      ()
+    , m_peerLength( 0 )
     {
     }
 
-    Socket::Socket( const char *a_address, uint32_t a_port, uint32_t a_flags /*= 0*/ )
-    : m_valid ( false )
-    , m_error ( 0 )
-    , m_flags ( a_flags )
+    Socket::Socket( const char *a_address, uint32_t a_port, uint32_t a_flags /*= 0*/, int32_t a_backlog /*= 100*/ )
+    : m_sockfd    ( -1 )
+    , m_valid     ( false )
+    , m_error     ( 0 )
+    , m_flags     ( a_flags )
+    , m_peer      ()
+    , m_peerLength( 0 )
     {
         char port[ 16 ]; // 32-bit input could be 10 digits + 1 for NULL terminator, so 11 minimum should be allocated
         snprintf( port, sizeof( port ), "%d", a_port );
-        m_sockfd = Initialize( a_address, port );
+        m_sockfd = Initialize( a_address, port, a_backlog );
         if( m_sockfd < 0 )
         {
             m_valid = false;
@@ -49,7 +60,7 @@ namespace utils
         Shutdown();
     }
 
-    int32_t Socket::Initialize( const char *a_address, const char *a_service )
+    int32_t Socket::Initialize( const char *a_address, const char *a_service, int32_t a_backlog )
     {
         int32_t sockfd = -1;
         if( a_address )
@@ -64,7 +75,12 @@ namespace utils
             {
                 for ( struct addrinfo *item = result; nullptr != item; item = item->ai_next )
                 {
-                    sockfd = socket( item->ai_family, item->ai_socktype, item->ai_protocol );
+                    int32_t type = item->ai_socktype | SOCK_CLOEXEC;
+                    if( m_flags[ SocketFlag::Server ] && m_flags[ SocketFlag::NonBlocking ] )
+                    {
+                        type |= SOCK_NONBLOCK;
+                    }
+                    sockfd = socket( item->ai_family, type, item->ai_protocol );
                     if ( sockfd < 0 )
                     {
                         continue;
@@ -73,7 +89,9 @@ namespace utils
                     if( m_flags[ SocketFlag::Server ] )
                     {
                         int yes = 1;
-                        if( 0 == setsockopt( sockfd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof( int ) ) )
+                        if( ( 0 == setsockopt( sockfd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof( int ) ) ) &&
+                            ( !m_flags[ SocketFlag::ReusePort ] ||
+                              ( 0 == setsockopt( sockfd, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof( int ) ) ) ) )
                         {
                             if( 0 == bind( sockfd, item->ai_addr, item->ai_addrlen ) )
                             {
@@ -81,35 +99,48 @@ namespace utils
                                 {
                                     break;
                                 }
-                                if( 0 == listen( sockfd, 100 ) )
+                                if( 0 == listen( sockfd, a_backlog ) )
                                 {
                                     break;
                                 }
                                 m_error = errno;
-                                Shutdown();
+                                close( sockfd );
+                                sockfd  = -1;
+                                m_valid = false;
                             }
                             else
                             {
                                 m_error = errno;
-                                Shutdown();
+                                close( sockfd );
+                                sockfd  = -1;
+                                m_valid = false;
                             }
                         }
                         else
                         {
                             m_error = errno;
-                            Shutdown();
+                            close( sockfd );
+                            sockfd  = -1;
+                            m_valid = false;
                         }
                     }
                     else
                     {
                         if( 0 == connect( sockfd, item->ai_addr, item->ai_addrlen ) )
                         {
+                            // Connect blocking, then switch modes if requested
+                            if( m_flags[ SocketFlag::NonBlocking ] )
+                            {
+                                fcntl( sockfd, F_SETFL, fcntl( sockfd, F_GETFL ) | O_NONBLOCK );
+                            }
                             break;
                         }
                         else
                         {
                             m_error = errno;
-                            Shutdown();
+                            close( sockfd );
+                            sockfd  = -1;
+                            m_valid = false;
                         }
                     }
                 }
@@ -122,7 +153,7 @@ namespace utils
         else
         {
             m_error = errno;
-            Shutdown();
+            m_valid = false;
         }
         if( m_valid )
         {
@@ -149,47 +180,168 @@ namespace utils
         return m_valid;
     }
 
-    ::std::shared_ptr< Socket > Socket::Accept( ::std::string &a_address, uint32_t &a_port )
+    ::std::shared_ptr< Socket > Socket::Accept()
     {
         ::utils::Lock lock( this );
         struct sockaddr_storage address;
         socklen_t length    = sizeof( address );
-        int32_t   client_fd = accept( m_sockfd, ( struct sockaddr * )&address, &length );
+        int32_t   client_fd = -1;
+        int32_t   flags     = SOCK_CLOEXEC | ( m_flags[ SocketFlag::NonBlocking ]? SOCK_NONBLOCK: 0 );
+        do
+        {
+            length    = sizeof( address );
+            client_fd = accept4( m_sockfd, ( struct sockaddr * )&address, &length, flags );
+        } while( ( client_fd < 0 ) && ( EINTR == errno ) );
         if( client_fd >= 0 )
         {
-            uint32_t port = 0;
-            char     addr[ INET6_ADDRSTRLEN + 1 ] = { 0 };
-            if ( address.ss_family == AF_INET )
-            {
-                struct sockaddr_in *s = ( struct sockaddr_in * )&address;
-                port = ntohs( s->sin_port );
-                inet_ntop( AF_INET, &( s->sin_addr ), addr, sizeof( addr ) );
-            }
-            else
-            {
-                struct sockaddr_in6 *s = ( struct sockaddr_in6 * )&address;
-                port = ntohs( s->sin6_port );
-                inet_ntop( AF_INET6, &( s->sin6_addr ), addr, sizeof( addr ) );
-            }
-            a_port    = port;
-            a_address = addr;
-            utils::BitMask flags( m_flags );
-            flags.SetBit( SocketFlags::Server, false );
-            ::std::shared_ptr< Socket > client = ::std::make_shared< Socket >( client_fd, ( unsigned int )flags );
+            utils::BitMask clientFlags( m_flags );
+            clientFlags.SetBit( SocketFlags::Server, false );
+            ::std::shared_ptr< Socket > client = ::std::make_shared< Socket >( client_fd, ( unsigned int )clientFlags );
             if( client )
             {
                 client->m_flags.SetBit( SocketFlags::Server, false );
+                memcpy( &( client->m_peer ), &address, length );
+                client->m_peerLength = length;
             }
             return client;
         }
         m_error = errno;
-        if( ( m_error != EAGAIN ) && ( m_error != EWOULDBLOCK ) )
+        switch( m_error )
         {
-            Shutdown();
+            // The pending connection failed or we are short on resources;
+            // the listener itself is fine.
+            case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+            case EWOULDBLOCK:
+#endif
+            case ECONNABORTED:
+            case EPROTO:
+            case EPERM:
+            case EMFILE:
+            case ENFILE:
+            case ENOBUFS:
+            case ENOMEM:
+                break;
+            default:
+                Shutdown();
+                break;
         }
         return nullptr;
     }
 
+    ::std::shared_ptr< Socket > Socket::Accept( ::std::string &a_address, uint32_t &a_port )
+    {
+        ::std::shared_ptr< Socket > client = Accept();
+        if( client )
+        {
+            client->PeerAddress( a_address, a_port );
+        }
+        return client;
+    }
+
+    bool Socket::PeerAddress( ::std::string &a_address, uint32_t &a_port )
+    {
+        ::utils::Lock lock( this );
+        if( 0 == m_peerLength )
+        {
+            socklen_t length = sizeof( m_peer );
+            if( ( m_sockfd < 0 ) || ( 0 != getpeername( m_sockfd, ( struct sockaddr * )&m_peer, &length ) ) )
+            {
+                return false;
+            }
+            m_peerLength = length;
+        }
+        char addr[ INET6_ADDRSTRLEN + 1 ] = { 0 };
+        if( m_peer.ss_family == AF_INET )
+        {
+            struct sockaddr_in *s = ( struct sockaddr_in * )&m_peer;
+            a_port = ntohs( s->sin_port );
+            inet_ntop( AF_INET, &( s->sin_addr ), addr, sizeof( addr ) );
+        }
+        else
+        {
+            struct sockaddr_in6 *s = ( struct sockaddr_in6 * )&m_peer;
+            a_port = ntohs( s->sin6_port );
+            inet_ntop( AF_INET6, &( s->sin6_addr ), addr, sizeof( addr ) );
+        }
+        a_address = addr;
+        return true;
+    }
+
+    bool Socket::WaitFor( int16_t a_events, int32_t a_timeoutMs )
+    {
+        struct pollfd pfd;
+        pfd.fd      = m_sockfd;
+        pfd.events  = a_events;
+        pfd.revents = 0;
+        int32_t result = 0;
+        do
+        {
+            result = poll( &pfd, 1, a_timeoutMs );
+        } while( ( result < 0 ) && ( EINTR == errno ) );
+        return ( result > 0 );
+    }
+
+    bool Socket::WaitForRead( int32_t a_timeoutMs )
+    {
+        // No socket lock: a listener is waited on while other threads may
+        // call Interrupt, and the wait must not block them.
+        return ( m_sockfd >= 0 ) && WaitFor( POLLIN, a_timeoutMs );
+    }
+
+    bool Socket::SetOption( int32_t a_level, int32_t a_name, int32_t a_value )
+    {
+        ::utils::Lock lock( this );
+        if( ( m_sockfd < 0 ) || ( 0 != setsockopt( m_sockfd, a_level, a_name, &a_value, sizeof( a_value ) ) ) )
+        {
+            m_error = errno;
+            return false;
+        }
+        return true;
+    }
+
+    bool Socket::SetNoDelay( bool a_enable )
+    {
+        return SetOption( IPPROTO_TCP, TCP_NODELAY, a_enable? 1: 0 );
+    }
+
+    bool Socket::SetDeferAccept( uint32_t a_seconds )
+    {
+        return SetOption( IPPROTO_TCP, TCP_DEFER_ACCEPT, static_cast< int32_t >( a_seconds ) );
+    }
+
+    bool Socket::SetFastOpen( uint32_t a_queue )
+    {
+        return SetOption( IPPROTO_TCP, TCP_FASTOPEN, static_cast< int32_t >( a_queue ) );
+    }
+
+    bool Socket::SetSendBuffer( uint32_t a_bytes )
+    {
+        return SetOption( SOL_SOCKET, SO_SNDBUF, static_cast< int32_t >( a_bytes ) );
+    }
+
+    bool Socket::SetReceiveBuffer( uint32_t a_bytes )
+    {
+        return SetOption( SOL_SOCKET, SO_RCVBUF, static_cast< int32_t >( a_bytes ) );
+    }
+
+    bool Socket::SetNotSentLowat( uint32_t a_bytes )
+    {
+        return SetOption( IPPROTO_TCP, TCP_NOTSENT_LOWAT, static_cast< int32_t >( a_bytes ) );
+    }
+
+    bool Socket::SetKeepAlive( bool a_enable, uint32_t a_idle /*= 0*/, uint32_t a_interval /*= 0*/, uint32_t a_count /*= 0*/ )
+    {
+        bool ok = SetOption( SOL_SOCKET, SO_KEEPALIVE, a_enable? 1: 0 );
+        if( ok && a_enable )
+        {
+            ok = ( ( 0 == a_idle     ) || SetOption( IPPROTO_TCP, TCP_KEEPIDLE,  static_cast< int32_t >( a_idle ) ) ) && ok;
+            ok = ( ( 0 == a_interval ) || SetOption( IPPROTO_TCP, TCP_KEEPINTVL, static_cast< int32_t >( a_interval ) ) ) && ok;
+            ok = ( ( 0 == a_count    ) || SetOption( IPPROTO_TCP, TCP_KEEPCNT,   static_cast< int32_t >( a_count ) ) ) && ok;
+        }
+        return ok;
+    }
+
     int32_t Socket::LastError()
     {
         ::utils::Lock lock( this );
@@ -199,16 +351,29 @@ namespace utils
     void Socket::Shutdown()
     {
         ::utils::Lock lock( this );
-        if( m_sockfd >= 0 )
         {
-            fsync( m_sockfd );
-            close( m_sockfd );
+            ::utils::Lock descriptorLock( &m_descriptor );
+            int32_t sockfd = m_sockfd.exchange( -1 );
+            if( sockfd >= 0 )
+            {
+                fsync( sockfd );
+                close( sockfd );
+            }
         }
-        m_sockfd = -1;
         m_valid  = false;
         m_error  = errno;
     }
 
+    void Socket::Interrupt()
+    {
+        ::utils::Lock descriptorLock( &m_descriptor );
+        int32_t sockfd = m_sockfd.load();
+        if( sockfd >= 0 )
+        {
+            shutdown( sockfd, SHUT_RDWR );
+        }
+    }
+
     bool Socket::IsReadable() noexcept
     {
         // Cannot use Valid() since Valid() may call IsReadable()
@@ -237,6 +402,10 @@ namespace utils
             if( ( sizeof( a_value ) == result ) || a_block )
             {
                 result = recv( m_sockfd, &a_value, sizeof( uint8_t ), 0 );
+                if( ( result < 0 ) && a_block && WouldBlock( errno ) && WaitFor( POLLIN, -1 ) )
+                {
+                    result = recv( m_sockfd, &a_value, sizeof( uint8_t ), 0 );
+                }
             }
             if( result <= 0 )
             {
@@ -265,6 +434,10 @@ namespace utils
             if( ( read > 0 ) || a_block )
             {
                 read = recv( m_sockfd, a_value, a_length, 0 );
+                if( ( read < 0 ) && a_block && WouldBlock( errno ) && WaitFor( POLLIN, -1 ) )
+                {
+                    read = recv( m_sockfd, a_value, a_length, 0 );
+                }
             }
             if( read <= 0 )
             {
@@ -400,6 +573,10 @@ namespace utils
         if( ok )
         {
             int32_t result = send( m_sockfd, &a_value, sizeof( uint8_t ), 0 );
+            while( ( result < 0 ) && WouldBlock( errno ) && WaitFor( POLLOUT, -1 ) )
+            {
+                result = send( m_sockfd, &a_value, sizeof( uint8_t ), 0 );
+            }
             if( result < 0 )
             {
                 ok = false;
@@ -424,7 +601,13 @@ namespace utils
             {
                 total += result;
             }
-            if( result <= 0 )
+            else if( ( result < 0 ) && WouldBlock( errno ) )
+            {
+                // Send buffer full on a non-blocking socket; Valid() waits
+                // for it to drain before the next attempt.
+                continue;
+            }
+            else
             {
                 Shutdown();
             }
@@ -453,4 +636,44 @@ namespace utils
         }
         return ( sent > 0 );
     }
+
+    bool SocketOptions::Empty() const
+    {
+        return !noDelay && !deferAccept && !fastOpen && !sendBuffer &&
+               !receiveBuffer && !notSentLowat && !keepAlive;
+    }
+
+    bool SocketOptions::Apply( Socket &a_socket ) const
+    {
+        bool ok = true;
+        if( noDelay )
+        {
+            ok = a_socket.SetNoDelay( *noDelay ) && ok;
+        }
+        if( deferAccept )
+        {
+            ok = a_socket.SetDeferAccept( *deferAccept ) && ok;
+        }
+        if( fastOpen )
+        {
+            ok = a_socket.SetFastOpen( *fastOpen ) && ok;
+        }
+        if( sendBuffer )
+        {
+            ok = a_socket.SetSendBuffer( *sendBuffer ) && ok;
+        }
+        if( receiveBuffer )
+        {
+            ok = a_socket.SetReceiveBuffer( *receiveBuffer ) && ok;
+        }
+        if( notSentLowat )
+        {
+            ok = a_socket.SetNotSentLowat( *notSentLowat ) && ok;
+        }
+        if( keepAlive )
+        {
+            ok = a_socket.SetKeepAlive( *keepAlive, keepIdle, keepInterval, keepCount ) && ok;
+        }
+        return ok;
+    }
 }
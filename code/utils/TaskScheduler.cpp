@@ -0,0 +1,395 @@
+/**
+    TaskScheduler.cpp : TaskScheduler implementation
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#include <utils/TaskScheduler.hpp>
+#include <utils/Thread.hpp>
+#include <pthread.h>
+#include <sched.h>
+
+#define TASKSCHEDULER_DEQUE     256 // Initial per-worker deque size (power of two)
+#define TASKSCHEDULER_SPINS     64  // Failed work searches before parking
+
+namespace utils
+{
+    struct TaskWorkerCTX
+    {
+        TaskScheduler *scheduler = nullptr;
+        uint32_t       index     = 0;
+        int32_t        cpu       = -1;
+    };
+
+    static thread_local TaskScheduler *t_scheduler = nullptr;
+    static thread_local uint32_t       t_index     = 0;
+
+    /**
+     * @brief One worker thread and its Chase-Lev work-stealing deque.
+     * @details The owner pushes and pops at the bottom; thieves take from the
+     *          top. The ring grows when full; replaced rings are retired
+     *          rather than freed because a thief may still be reading one.
+     */
+    class TaskScheduler::Worker
+    {
+        private:
+            struct Ring
+            {
+                int64_t                                        mask;
+                ::std::unique_ptr< ::std::atomic< Task * >[] > slots;
+
+                Ring( int64_t a_capacity )
+                : mask( a_capacity - 1 )
+                , slots( new ::std::atomic< Task * >[ a_capacity ] )
+                {
+                }
+
+                int64_t Capacity() const
+                {
+                    return mask + 1;
+                }
+
+                Task *Get( int64_t a_index ) const
+                {
+                    return slots[ a_index & mask ].load( ::std::memory_order_relaxed );
+                }
+
+                void Put( int64_t a_index, Task *a_task )
+                {
+                    slots[ a_index & mask ].store( a_task, ::std::memory_order_relaxed );
+                }
+            };
+
+            alignas( 64 ) ::std::atomic< int64_t >     m_top;
+            alignas( 64 ) ::std::atomic< int64_t >     m_bottom;
+            ::std::atomic< Ring * >                    m_ring;
+            ::std::vector< ::std::unique_ptr< Ring > > m_rings;
+
+        public:
+            Thread< TaskWorkerCTX > thread;
+
+            Worker()
+            : m_top( 0 )
+            , m_bottom( 0 )
+            , m_ring( nullptr )
+            , m_rings()
+            , thread( TaskScheduler::Run )
+            {
+                m_rings.push_back( ::std::make_unique< Ring >( TASKSCHEDULER_DEQUE ) );
+                m_ring.store( m_rings.back().get(), ::std::memory_order_relaxed );
+            }
+
+            ~Worker()
+            {
+                // Only reached after the thread has been joined
+                Task *task = nullptr;
+                while( nullptr != ( task = Pop() ) )
+                {
+                    delete task;
+                }
+            }
+
+            // Owner only
+            void Push( Task *a_task )
+            {
+                int64_t bottom = m_bottom.load( ::std::memory_order_relaxed );
+                int64_t top    = m_top.load( ::std::memory_order_acquire );
+                Ring   *ring   = m_ring.load( ::std::memory_order_relaxed );
+                if( ( bottom - top ) >= ring->Capacity() )
+                {
+                    m_rings.push_back( ::std::make_unique< Ring >( ring->Capacity() * 2 ) );
+                    Ring *larger = m_rings.back().get();
+                    for( int64_t i = top; i < bottom; ++i )
+                    {
+                        larger->Put( i, ring->Get( i ) );
+                    }
+                    ring = larger;
+                    m_ring.store( ring, ::std::memory_order_release );
+                }
+                ring->Put( bottom, a_task );
+                ::std::atomic_thread_fence( ::std::memory_order_release );
+                m_bottom.store( bottom + 1, ::std::memory_order_relaxed );
+            }
+
+            // Owner only
+            Task *Pop()
+            {
+                int64_t bottom = m_bottom.load( ::std::memory_order_relaxed ) - 1;
+                Ring   *ring   = m_ring.load( ::std::memory_order_relaxed );
+                m_bottom.store( bottom, ::std::memory_order_relaxed );
+                ::std::atomic_thread_fence( ::std::memory_order_seq_cst );
+                int64_t top  = m_top.load( ::std::memory_order_relaxed );
+                Task   *task = nullptr;
+                if( top <= bottom )
+                {
+                    task = ring->Get( bottom );
+                    if( top == bottom )
+                    {
+                        // Last element; race any thief for it
+                        if( !m_top.compare_exchange_strong( top, top + 1,
+                                                            ::std::memory_order_seq_cst,
+                                                            ::std::memory_order_relaxed ) )
+                        {
+                            task = nullptr;
+                        }
+                        m_bottom.store( bottom + 1, ::std::memory_order_relaxed );
+                    }
+                }
+                else
+                {
+                    m_bottom.store( bottom + 1, ::std::memory_order_relaxed );
+                }
+                return task;
+            }
+
+            // Any thread
+            Task *Steal()
+            {
+                int64_t top = m_top.load( ::std::memory_order_acquire );
+                ::std::atomic_thread_fence( ::std::memory_order_seq_cst );
+                int64_t bottom = m_bottom.load( ::std::memory_order_acquire );
+                if( top >= bottom )
+                {
+                    return nullptr;
+                }
+                Ring *ring = m_ring.load( ::std::memory_order_acquire );
+                Task *task = ring->Get( top );
+                if( !m_top.compare_exchange_strong( top, top + 1,
+                                                    ::std::memory_order_seq_cst,
+                                                    ::std::memory_order_relaxed ) )
+                {
+                    // Lost the race to the owner or another thief
+                    return nullptr;
+                }
+                return task;
+            }
+    };
+
+    static void Execute( TaskScheduler::Task *a_task )
+    {
+        try
+        {
+            ( *a_task )();
+        }
+        catch( const ::std::exception &e )
+        {
+            UNUSED( e );
+        }
+        catch( ... )
+        {
+        }
+        delete a_task;
+    }
+
+    TaskScheduler::TaskScheduler()
+    : TaskScheduler( 0 )
+    {
+    }
+
+    TaskScheduler::TaskScheduler( uint32_t a_workers, bool a_pinWorkers, uint32_t a_queueCapacity )
+    : m_workers()
+    , m_injection( a_queueCapacity )
+    , m_cpus()
+    , m_pending( 0 )
+    , m_idle( 0 )
+    , m_stopping( false )
+    {
+        cpu_set_t allowed;
+        CPU_ZERO( &allowed );
+        if( 0 == sched_getaffinity( 0, sizeof( allowed ), &allowed ) )
+        {
+            for( int32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+            {
+                if( CPU_ISSET( cpu, &allowed ) )
+                {
+                    m_cpus.push_back( cpu );
+                }
+            }
+        }
+        if( 0 == a_workers )
+        {
+            a_workers = m_cpus.empty() ? ::std::max( 1U, ::std::thread::hardware_concurrency() )
+                                       : static_cast< uint32_t >( m_cpus.size() );
+        }
+
+        // Create every worker before starting any so thieves see a fixed set
+        for( uint32_t i = 0; i < a_workers; ++i )
+        {
+            m_workers.push_back( ::std::make_unique< Worker >() );
+            TaskWorkerCTX &context = *( m_workers.back()->thread.GetContext() );
+            context.scheduler = this;
+            context.index     = i;
+            context.cpu       = ( a_pinWorkers && !m_cpus.empty() ) ? m_cpus[ i % m_cpus.size() ] : -1;
+        }
+        for( auto &worker : m_workers )
+        {
+            worker->thread.Start();
+        }
+    }
+
+    TaskScheduler::~TaskScheduler()
+    {
+        {
+            ::std::lock_guard< ::std::mutex > lock( m_parkMutex );
+            m_stopping.store( true, ::std::memory_order_seq_cst );
+        }
+        m_park.notify_all();
+        for( auto &worker : m_workers )
+        {
+            worker->thread.Join();
+        }
+
+        // Workers drain all work before exiting; this only catches tasks
+        // posted from outside while the scheduler was being destroyed.
+        Task *task = nullptr;
+        while( m_injection.Dequeue( task ) )
+        {
+            delete task;
+        }
+    }
+
+    uint32_t TaskScheduler::Workers() const
+    {
+        return static_cast< uint32_t >( m_workers.size() );
+    }
+
+    TaskScheduler *TaskScheduler::Current()
+    {
+        return t_scheduler;
+    }
+
+    bool TaskScheduler::Post( Task &&a_task )
+    {
+        if( !a_task )
+        {
+            return false;
+        }
+        Task *task = new Task( ::std::move( a_task ) );
+
+        // Count the task before publishing it so a worker that is about to
+        // park sees either the count or the queued task.
+        m_pending.fetch_add( 1, ::std::memory_order_seq_cst );
+        if( this == t_scheduler )
+        {
+            m_workers[ t_index ]->Push( task );
+        }
+        else if( !m_injection.Enqueue( task ) )
+        {
+            // Injection queue is full; apply back-pressure by running inline
+            m_pending.fetch_sub( 1, ::std::memory_order_relaxed );
+            Execute( task );
+            return false;
+        }
+        Wake();
+        return true;
+    }
+
+    void TaskScheduler::Wake()
+    {
+        if( m_idle.load( ::std::memory_order_seq_cst ) > 0 )
+        {
+            // Taking the mutex orders this notify after the parked worker's
+            // predicate check, so the wakeup cannot be lost.
+            {
+                ::std::lock_guard< ::std::mutex > lock( m_parkMutex );
+            }
+            m_park.notify_one();
+        }
+    }
+
+    TaskScheduler::Task *TaskScheduler::FindWork( uint32_t a_self, uint64_t &a_seed )
+    {
+        Task    *task  = nullptr;
+        uint32_t count = static_cast< uint32_t >( m_workers.size() );
+        if( ( a_self < count ) && ( nullptr != ( task = m_workers[ a_self ]->Pop() ) ) )
+        {
+            return task;
+        }
+        if( m_injection.Dequeue( task ) )
+        {
+            return task;
+        }
+
+        // Steal from a random victim, then sweep the others
+        a_seed ^= a_seed << 13;
+        a_seed ^= a_seed >> 7;
+        a_seed ^= a_seed << 17;
+        uint32_t start = static_cast< uint32_t >( a_seed % count );
+        for( uint32_t i = 0; i < count; ++i )
+        {
+            uint32_t victim = ( start + i ) % count;
+            if( ( victim != a_self ) && ( nullptr != ( task = m_workers[ victim ]->Steal() ) ) )
+            {
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    bool TaskScheduler::RunOne()
+    {
+        static thread_local uint64_t seed = 0;
+        if( 0 == seed )
+        {
+            seed = reinterpret_cast< uintptr_t >( &seed ) | 1;
+        }
+        uint32_t self = ( this == t_scheduler ) ? t_index : static_cast< uint32_t >( m_workers.size() );
+        Task    *task = FindWork( self, seed );
+        if( nullptr == task )
+        {
+            return false;
+        }
+        m_pending.fetch_sub( 1, ::std::memory_order_relaxed );
+        Execute( task );
+        return true;
+    }
+
+    void *TaskScheduler::Run( void *a_context )
+    {
+        TaskWorkerCTX &context   = *reinterpret_cast< TaskWorkerCTX * >( a_context );
+        TaskScheduler &scheduler = *context.scheduler;
+        t_scheduler = context.scheduler;
+        t_index     = context.index;
+
+        if( context.cpu >= 0 )
+        {
+            cpu_set_t cpus;
+            CPU_ZERO( &cpus );
+            CPU_SET( context.cpu, &cpus );
+            pthread_setaffinity_np( pthread_self(), sizeof( cpus ), &cpus );
+        }
+
+        uint32_t spins = 0;
+        while( true )
+        {
+            if( scheduler.RunOne() )
+            {
+                spins = 0;
+                continue;
+            }
+            if( scheduler.m_stopping.load( ::std::memory_order_seq_cst ) &&
+                ( 0 == scheduler.m_pending.load( ::std::memory_order_seq_cst ) ) )
+            {
+                break;
+            }
+            if( ++spins < TASKSCHEDULER_SPINS )
+            {
+                ::std::this_thread::yield();
+                continue;
+            }
+            spins = 0;
+
+            ::std::unique_lock< ::std::mutex > lock( scheduler.m_parkMutex );
+            scheduler.m_idle.fetch_add( 1, ::std::memory_order_seq_cst );
+            scheduler.m_park.wait( lock, [ &scheduler ]()
+            {
+                return ( scheduler.m_pending.load( ::std::memory_order_seq_cst ) > 0 ) ||
+                       scheduler.m_stopping.load( ::std::memory_order_seq_cst );
+            } );
+            scheduler.m_idle.fetch_sub( 1, ::std::memory_order_seq_cst );
+        }
+
+        t_scheduler = nullptr;
+        return nullptr;
+    }
+}
@@ -0,0 +1,301 @@
+/**
+    TimerWheel.cpp : TimerWheel implementation
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#include <utils/TimerWheel.hpp>
+#include <utils/Lock.hpp>
+#include <algorithm>
+#include <bit>
+#include <exception>
+
+namespace utils
+{
+    TimerWheel::TimerWheel( uint32_t a_resolutionMs /*= 10*/ )
+    : m_nodes()
+    , m_free()
+    , m_now( 0 )
+    , m_count( 0 )
+    , m_resolution( ::std::max( 1U, a_resolutionMs ) )
+    , m_epoch( Clock::now() )
+    {
+        ::std::fill( m_heads, m_heads + ( WHEELS * SLOTS ), -1 );
+        ::std::fill( m_occupied, m_occupied + WHEELS, 0 );
+    }
+
+    uint64_t TimerWheel::Elapsed( Clock::time_point a_now ) const
+    {
+        if( a_now <= m_epoch )
+        {
+            return 0;
+        }
+        auto elapsed = ::std::chrono::duration_cast< ::std::chrono::milliseconds >( a_now - m_epoch ).count();
+        return static_cast< uint64_t >( elapsed ) / m_resolution;
+    }
+
+    uint64_t TimerWheel::Expiry( uint32_t a_delayMs ) const
+    {
+        // Count from the wall clock rather than m_now so a wheel that has
+        // not been ticked for a while does not fire new timers early
+        uint64_t ticks = ::std::max< uint64_t >( 1, ( static_cast< uint64_t >( a_delayMs ) + m_resolution - 1 ) / m_resolution );
+        return ::std::max( Elapsed( Clock::now() ), m_now ) + ticks;
+    }
+
+    int32_t TimerWheel::Find( TimerId a_id ) const
+    {
+        uint32_t index      = static_cast< uint32_t >( a_id & 0xFFFFFFFF );
+        uint32_t generation = static_cast< uint32_t >( a_id >> 32 );
+        if( ( index < m_nodes.size() ) &&
+            ( m_nodes[ index ].generation == generation ) &&
+            ( m_nodes[ index ].slot >= 0 ) )
+        {
+            return static_cast< int32_t >( index );
+        }
+        return -1;
+    }
+
+    void TimerWheel::Link( int32_t a_index )
+    {
+        Node    &node  = m_nodes[ a_index ];
+        uint64_t delta = ( node.expiry > m_now )? ( node.expiry - m_now ): 0;
+        uint64_t when  = node.expiry;
+        uint32_t wheel = 0;
+        while( ( wheel < ( WHEELS - 1 ) ) && ( delta >= ( 1ULL << ( BITS * ( wheel + 1 ) ) ) ) )
+        {
+            ++wheel;
+        }
+        if( delta >= ( 1ULL << ( BITS * WHEELS ) ) )
+        {
+            // Beyond the top wheel; park it in the last slot to be cascaded
+            // and file it again from there
+            when = m_now + ( 1ULL << ( BITS * WHEELS ) ) - 1;
+        }
+        uint32_t slot = static_cast< uint32_t >( when >> ( BITS * wheel ) ) & ( SLOTS - 1 );
+        int32_t &head = m_heads[ ( wheel * SLOTS ) + slot ];
+
+        node.slot = static_cast< int32_t >( ( wheel * SLOTS ) + slot );
+        node.prev = -1;
+        node.next = head;
+        if( head >= 0 )
+        {
+            m_nodes[ head ].prev = a_index;
+        }
+        head = a_index;
+        m_occupied[ wheel ] |= ( 1ULL << slot );
+    }
+
+    void TimerWheel::Unlink( int32_t a_index )
+    {
+        Node &node = m_nodes[ a_index ];
+        if( node.prev >= 0 )
+        {
+            m_nodes[ node.prev ].next = node.next;
+        }
+        else
+        {
+            m_heads[ node.slot ] = node.next;
+        }
+        if( node.next >= 0 )
+        {
+            m_nodes[ node.next ].prev = node.prev;
+        }
+        if( m_heads[ node.slot ] < 0 )
+        {
+            m_occupied[ node.slot / SLOTS ] &= ~( 1ULL << ( node.slot % SLOTS ) );
+        }
+        node.prev = -1;
+        node.next = -1;
+        node.slot = -1;
+    }
+
+    void TimerWheel::Release( int32_t a_index )
+    {
+        Node &node = m_nodes[ a_index ];
+        node.callback = nullptr;
+        // Outstanding ids for this node no longer match
+        if( 0 == ++node.generation )
+        {
+            node.generation = 1;
+        }
+        m_free.push_back( a_index );
+        --m_count;
+    }
+
+    void TimerWheel::Cascade( uint32_t a_wheel )
+    {
+        uint32_t slot = static_cast< uint32_t >( m_now >> ( BITS * a_wheel ) ) & ( SLOTS - 1 );
+        int32_t  node = -1;
+        while( ( node = m_heads[ ( a_wheel * SLOTS ) + slot ] ) >= 0 )
+        {
+            Unlink( node );
+            Link( node );
+        }
+    }
+
+    void TimerWheel::Step( ::std::vector< Callback > &a_due )
+    {
+        ++m_now;
+        uint32_t slot = static_cast< uint32_t >( m_now ) & ( SLOTS - 1 );
+        if( 0 == slot )
+        {
+            // The first wheel wrapped; pull the next slot of each higher
+            // wheel down until one of them has not wrapped too
+            for( uint32_t wheel = 1; wheel < WHEELS; ++wheel )
+            {
+                Cascade( wheel );
+                if( 0 != ( ( m_now >> ( BITS * wheel ) ) & ( SLOTS - 1 ) ) )
+                {
+                    break;
+                }
+            }
+        }
+
+        int32_t node = -1;
+        while( ( node = m_heads[ slot ] ) >= 0 )
+        {
+            Unlink( node );
+            if( m_nodes[ node ].expiry <= m_now )
+            {
+                a_due.push_back( ::std::move( m_nodes[ node ].callback ) );
+                Release( node );
+            }
+            else
+            {
+                Link( node );
+            }
+        }
+    }
+
+    TimerWheel::TimerId TimerWheel::Schedule( uint32_t a_delayMs, Callback &&a_callback )
+    {
+        ::utils::Lock lock( this );
+        if( !a_callback )
+        {
+            return 0;
+        }
+        int32_t index = -1;
+        if( m_free.empty() )
+        {
+            m_nodes.emplace_back();
+            index = static_cast< int32_t >( m_nodes.size() - 1 );
+        }
+        else
+        {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+        Node &node = m_nodes[ index ];
+        node.callback = ::std::move( a_callback );
+        node.expiry   = Expiry( a_delayMs );
+        Link( index );
+        ++m_count;
+        return ( static_cast< uint64_t >( node.generation ) << 32 ) | static_cast< uint32_t >( index );
+    }
+
+    bool TimerWheel::Reschedule( TimerId a_id, uint32_t a_delayMs )
+    {
+        ::utils::Lock lock( this );
+        int32_t index = Find( a_id );
+        if( index < 0 )
+        {
+            return false;
+        }
+        Unlink( index );
+        m_nodes[ index ].expiry = Expiry( a_delayMs );
+        Link( index );
+        return true;
+    }
+
+    bool TimerWheel::Cancel( TimerId a_id )
+    {
+        // Destroy the callback after the lock is released
+        Callback callback;
+        ::utils::Lock lock( this );
+        int32_t index = Find( a_id );
+        if( index < 0 )
+        {
+            return false;
+        }
+        Unlink( index );
+        callback = ::std::move( m_nodes[ index ].callback );
+        Release( index );
+        return true;
+    }
+
+    bool TimerWheel::Pending( TimerId a_id )
+    {
+        ::utils::Lock lock( this );
+        return ( Find( a_id ) >= 0 );
+    }
+
+    uint32_t TimerWheel::Tick( Clock::time_point a_now /*= Clock::now()*/ )
+    {
+        ::std::vector< Callback > due;
+        {
+            ::utils::Lock lock( this );
+            uint64_t target = Elapsed( a_now );
+            while( m_now < target )
+            {
+                if( 0 == m_count )
+                {
+                    m_now = target;
+                    break;
+                }
+                if( 0 == m_occupied[ 0 ] )
+                {
+                    // Nothing can fire before the next cascade; skip to it
+                    m_now = ::std::min( target - 1, m_now | ( SLOTS - 1 ) );
+                }
+                Step( due );
+            }
+        }
+
+        for( auto &callback : due )
+        {
+            try
+            {
+                callback();
+            }
+            catch( const ::std::exception &e )
+            {
+                UNUSED( e );
+            }
+            catch( ... )
+            {
+            }
+        }
+        return static_cast< uint32_t >( due.size() );
+    }
+
+    int32_t TimerWheel::NextTimeout( int32_t a_maxMs /*= -1*/ )
+    {
+        ::utils::Lock lock( this );
+        if( 0 == m_count )
+        {
+            return a_maxMs;
+        }
+        uint32_t slot  = static_cast< uint32_t >( m_now ) & ( SLOTS - 1 );
+        uint64_t ticks = SLOTS - slot; // Ticks to the next cascade
+        if( 0 != m_occupied[ 0 ] )
+        {
+            // Nearest non-empty slot after the current one
+            uint64_t ahead = ::std::rotr( m_occupied[ 0 ], static_cast< int32_t >( ( slot + 1 ) & ( SLOTS - 1 ) ) );
+            ticks = ::std::min< uint64_t >( ticks, static_cast< uint64_t >( ::std::countr_zero( ahead ) ) + 1 );
+        }
+        auto due  = m_epoch + ::std::chrono::milliseconds( ( m_now + ticks ) * m_resolution );
+        auto wait = ::std::chrono::ceil< ::std::chrono::milliseconds >( due - Clock::now() ).count();
+        wait = ::std::max< int64_t >( 0, wait );
+        if( a_maxMs >= 0 )
+        {
+            wait = ::std::min< int64_t >( wait, a_maxMs );
+        }
+        return static_cast< int32_t >( ::std::min< int64_t >( wait, INT32_MAX ) );
+    }
+
+    uint32_t TimerWheel::Size()
+    {
+        ::utils::Lock lock( this );
+        return m_count;
+    }
+}
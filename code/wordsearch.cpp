@@ -56,8 +56,9 @@ int main( int argc, char *argv[] )
     input_thread->GetContext()->run = true;
     input_thread->Start();
 
-    // List of words to use in the word search
-    Staque< ::std::string > word_list;
+    // List of words to use in the word search; only this thread touches it
+    // and it is indexed at random, so use unlocked block storage
+    Staque< ::std::string, NoLockPolicy, StaqueBlocks > word_list;
 
     // Read input file, if provided
     if( argc >= 2 )
@@ -0,0 +1,74 @@
+/**
+    Base64.hpp : Base64 definition
+    Description: Table-driven Base64 encoding and decoding.
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#pragma once
+
+#ifndef _BASE64_HPP_
+#define _BASE64_HPP_
+
+#include <utils/Types.hpp>
+#include <stddef.h>
+#include <string>
+
+namespace utils
+{
+    /**
+     * @brief Standard (RFC 4648) Base64 encoding and decoding.
+     * @details Both directions work through lookup tables, three bytes to
+     *          four characters at a time, and write straight into a buffer
+     *          sized up front instead of appending one character at a time.
+     *          Decoding is lenient in the way HTTP headers and htpasswd
+     *          files need: whitespace is skipped, input ends at the first
+     *          `=`, and missing padding is accepted.
+     */
+    class Base64
+    {
+        public:
+            /**
+             * @brief Get the encoded length of some data, including padding.
+             * @param a_len Length of the data in bytes.
+             * @return Number of characters Encode produces.
+             */
+            static size_t EncodedLength( size_t a_len );
+
+            /**
+             * @brief Get the largest decoded length of some encoded text.
+             * @param a_len Length of the encoded text in characters.
+             * @return Buffer size that always holds the decoded bytes.
+             */
+            static size_t DecodedLength( size_t a_len );
+
+            /**
+             * @brief Encode data and append it to a string.
+             * @param a_data Data to encode.
+             * @param a_len Length of a_data in bytes.
+             * @param a_output String the padded encoding is appended to.
+             */
+            static void Encode( const uint8_t *a_data, size_t a_len, ::std::string &a_output );
+
+            /**
+             * @brief Decode text into a caller-provided buffer.
+             * @param a_input Encoded text.
+             * @param a_len Length of a_input in characters.
+             * @param a_output Buffer of at least DecodedLength( a_len ) bytes.
+             * @param a_outputLen Receives the number of bytes decoded.
+             * @return True if the text was valid Base64; false if it
+             *         contained another character.
+             */
+            static bool Decode( const char *a_input, size_t a_len, uint8_t *a_output, size_t &a_outputLen );
+
+            /**
+             * @brief Decode text into a string.
+             * @param a_input Encoded text.
+             * @param a_output Replaced with the decoded bytes.
+             * @return True if the text was valid Base64; false otherwise.
+             */
+            static bool Decode( const ::std::string &a_input, ::std::string &a_output );
+    };
+}
+
+#endif // _BASE64_HPP_
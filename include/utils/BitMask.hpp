@@ -21,11 +21,11 @@ namespace utils
     /**
      * @brief Thread-aware bitmask utility for flag-style operations.
      * @details Stores a 32-bit mask and provides helpers to set, clear, and query
-     *          individual bits. Some methods take an internal lock, but callers
-     *          should still synchronize if the same instance is accessed from
-     *          multiple threads concurrently.
+     *          individual bits. Some methods take an internal spinlock, but
+     *          callers should still synchronize if the same instance is
+     *          accessed from multiple threads concurrently.
      */
-    class BitMask : public Lockable
+    class BitMask : public BasicLockable< SpinLockPolicy >
     {
         public:
             /**
@@ -0,0 +1,167 @@
+/**
+    DirectoryListing.hpp : DirectoryListing class definition
+    Description: Cached directory enumeration for generated indexes.
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#pragma once
+
+#ifndef _DIRECTORYLISTING_HPP_
+#define _DIRECTORYLISTING_HPP_
+
+#include <utils/Types.hpp>
+#include <utils/Lockable.hpp>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace utils
+{
+    /**
+     * @brief Sorted directory contents, cached by directory and mtime.
+     * @details A directory is read with getdents64 into one block of names,
+     *          which is sorted by index instead of one string per entry.
+     *          The HTML for the entries is rendered once and kept with the
+     *          names, so repeat requests for an unchanged directory cost a
+     *          stat and a lookup. A listing is reused only while the
+     *          directory's mtime and inode match, and one changed within the
+     *          last second is not cached, since a later change in the same
+     *          timestamp tick would go unnoticed.
+     *
+     *          The cache is bounded by bytes. A listing larger than an
+     *          eighth of it is not kept, and a very large directory's HTML
+     *          is not rendered up front; callers stream it with AppendHtml.
+     *          Listings are evicted oldest first, except that one read since
+     *          it was last considered gets another turn, so a crawl of many
+     *          directories does not push out the ones in regular use.
+     * @note Thread-safe. Lookups take a shared lock; directories are read
+     *       without the lock and listings are immutable once returned.
+     */
+    class DirectoryListing : public BasicLockable< SharedLockPolicy >
+    {
+        public:
+            struct Listing
+            {
+                struct Name
+                {
+                    uint32_t offset;
+                    uint32_t length;
+                };
+
+                ::std::string         names;       // Entry names back to back; directories end in '/'
+                ::std::vector< Name > sorted;      // Into names, in byte order
+                ::std::string         html;        // Rendered entries, or empty when streamed
+                int64_t               modTime = 0; // Directory mtime in nanoseconds
+                uint64_t              inode   = 0;
+
+                size_t             Count() const { return sorted.size(); }
+                ::std::string_view Entry( size_t a_index ) const
+                {
+                    return ::std::string_view( names.data() + sorted[ a_index ].offset, sorted[ a_index ].length );
+                }
+                size_t             Bytes() const
+                {
+                    return names.capacity() + html.capacity() + ( sorted.capacity() * sizeof( Name ) ) + sizeof( Listing );
+                }
+            };
+
+        private:
+            struct Entry
+            {
+                ::std::shared_ptr< const Listing >     listing;
+                ::std::list< ::std::string >::iterator position;      // In m_order
+                ::std::atomic< bool >                  used = false;  // Read since last considered for eviction
+            };
+
+            ::std::unordered_map< ::std::string, Entry > m_entries; // By directory path
+            ::std::list< ::std::string >                 m_order;   // Directory paths, oldest first
+            size_t                                       m_bytes;
+            size_t                                       m_capacity;
+
+            // Drop listings from the old end until a_bytes more would fit;
+            // the caller holds the exclusive lock
+            void Evict( size_t a_bytes );
+
+        public:
+            /**
+             * @brief Create a listing cache.
+             * @param a_capacity Most bytes of listings to keep; zero keeps
+             *                   none.
+             */
+            DirectoryListing( size_t a_capacity = 16777216 );
+
+            DirectoryListing( const DirectoryListing & ) = delete;
+            DirectoryListing &operator =( const DirectoryListing & ) = delete;
+
+            /**
+             * @brief Change the cache size, dropping listings as needed.
+             * @param a_capacity Most bytes of listings to keep.
+             */
+            void SetCapacity( size_t a_capacity );
+
+            /**
+             * @brief Get a directory's listing.
+             * @details Symbolic links and names starting with '.' are left
+             *          out.
+             * @param a_path Path of the directory.
+             * @param a_listing Receives the listing, cached or newly read.
+             * @return True if the directory could be read; false otherwise.
+             */
+            bool Get( const ::std::string &a_path, ::std::shared_ptr< const Listing > &a_listing );
+
+            /**
+             * @brief Drop every cached listing.
+             */
+            void Clear();
+
+            /**
+             * @brief Read a directory without the cache.
+             * @param a_path Path of the directory.
+             * @param a_listing Receives the sorted names; html is left
+             *                  empty.
+             * @return True if the directory could be read; false otherwise.
+             */
+            static bool Read( const ::std::string &a_path, Listing &a_listing );
+
+            /**
+             * @brief Render entries as HTML and append them to a string.
+             * @param a_listing Listing to render.
+             * @param a_first Index of the first entry.
+             * @param a_count Most entries to render.
+             * @param a_output String the markup is appended to.
+             */
+            static void AppendHtml( const Listing &a_listing, size_t a_first, size_t a_count, ::std::string &a_output );
+
+            /**
+             * @brief Render entries as JSON objects and append them.
+             * @details Each object has the entry's name (without a trailing
+             *          '/'), type ("file" or "directory"), size in bytes, and
+             *          mtime in UNIX seconds. Only these entries are stat'ed,
+             *          so a page of a large directory costs a page of stats.
+             *          Entries removed since the listing was read are left
+             *          out.
+             * @param a_listing Listing to render.
+             * @param a_path Path of the listed directory.
+             * @param a_first Index of the first entry.
+             * @param a_count Most entries to render.
+             * @param a_started Whether an object was already written; each
+             *                  later object is preceded by a comma.
+             * @param a_output String the objects are appended to.
+             */
+            static void AppendJson( const Listing &a_listing, const ::std::string &a_path, size_t a_first, size_t a_count,
+                                    bool &a_started, ::std::string &a_output );
+
+            /**
+             * @brief Get the process-wide listing cache.
+             * @return The shared cache.
+             */
+            static DirectoryListing &Shared();
+    };
+}
+
+#endif // _DIRECTORYLISTING_HPP_
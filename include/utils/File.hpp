@@ -14,6 +14,7 @@
 #include <utils/Readable.hpp>
 #include <utils/Types.hpp>
 #include <utils/Writable.hpp>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <stdio.h>
@@ -51,16 +52,18 @@ namespace utils
                  public Writable
     {
         protected:
-            ::std::string  m_fileName;
-            uint32_t       m_mode;
-            struct stat    m_cachedStat;
-            bool           m_cachedStatValid;
-            bool           m_cachedPathExists;
-            uint32_t       m_lastModTime;
-            bool           m_lastModTimeValid;
-            bool           m_modifiedLocally;
-            FILE          *m_file;
-            bool           m_ready;
+            ::std::string         m_fileName;
+            uint32_t              m_mode;
+            struct stat           m_cachedStat;
+            bool                  m_cachedStatValid;
+            bool                  m_cachedPathExists;
+            uint32_t              m_lastModTime;
+            bool                  m_lastModTimeValid;
+            bool                  m_modifiedLocally;
+            uint64_t              m_watch;     // FileWatcher id; zero when not watched
+            ::std::atomic< bool > m_statStale; // Set by the watcher on a change
+            FILE                 *m_file;
+            bool                  m_ready;
 
         public:
             /**
@@ -142,6 +145,18 @@ namespace utils
              */
             uint32_t ModificationTime();
 
+            /**
+             * @brief Follow changes to the path with FileWatcher::Shared().
+             * @details Once watched, IsModified and ModificationTime reuse
+             *          the cached stat until the watcher reports a change,
+             *          instead of querying the filesystem on every call.
+             *          Changes by other processes show up after the
+             *          watcher's debounce interval.
+             * @return True if the path is watched; false if it has no name
+             *         or the watch could not be added.
+             */
+            bool     Watch();
+
             /**
              * @brief Seek to a new file position.
              * @param a_position Absolute byte offset to seek to.
@@ -0,0 +1,170 @@
+/**
+    FileWatcher.hpp : FileWatcher class definition
+    Description: Background file change notifications.
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#pragma once
+
+#ifndef _FILEWATCHER_HPP_
+#define _FILEWATCHER_HPP_
+
+#include <utils/Types.hpp>
+#include <utils/Lockable.hpp>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace utils
+{
+    template< typename type > class Thread;
+    struct FileWatcherCTX;
+
+    /**
+     * @brief Calls back when watched files change, from a background thread.
+     * @details Each watched file's directory is registered with inotify, so
+     *          a file that is rewritten in place, replaced by a rename (as
+     *          editors and htpasswd do), created, or deleted is noticed
+     *          without polling. Events are debounced: a burst of writes,
+     *          or the create/write/rename sequence of a replacement, is
+     *          checked once after the file has been quiet for the debounce
+     *          interval (or four intervals into a steady stream of writes).
+     *          An event only triggers callbacks once a stat shows that the
+     *          file's size, modification time, or inode really changed.
+     *          When inotify is unavailable, or a directory cannot be watched
+     *          (or disappears), those files are stat'ed on a fixed interval
+     *          instead.
+     *
+     *          Watches of the same path share one stat, so any number of
+     *          consumers can follow a file for the cost of one. Shared()
+     *          gives a process-wide watcher, letting every cache in a
+     *          program share a single thread and inotify descriptor.
+     *
+     *          Consumers keep a snapshot of whatever they derive from the
+     *          file, rebuild it in the callback, and swap it in; the request
+     *          path then never needs to check the file itself.
+     * @note Thread-safe. Callbacks run one at a time on the watcher's
+     *       thread, after its lock is released, so they may call Watch and
+     *       Unwatch. Once Unwatch returns, its callback is not running and
+     *       will not run again, so an object can Unwatch in its destructor.
+     */
+    class FileWatcher : public Lockable
+    {
+        public:
+            typedef uint64_t                                         WatchId;  // Zero is never a valid id
+            typedef ::std::function< void( const ::std::string & ) > Callback; // Receives the watched path
+
+        private:
+            typedef ::std::chrono::steady_clock::time_point Time;
+
+            struct WatchedFile
+            {
+                ::std::string                   path;
+                ::std::string                   directory;
+                ::std::string                   name;              // File name within the directory
+                ::std::map< WatchId, Callback > callbacks;         // Every watch of this path
+                int32_t                         descriptor = -1;   // inotify watch, or -1 when polled
+                bool                            exists     = false;
+                bool                            pending    = false; // An event is waiting out the debounce
+                Time                            since;             // First event of the pending burst
+                Time                            due;               // When the pending burst is checked
+                int64_t                         modTime    = 0;    // Nanoseconds
+                int64_t                         size       = 0;
+                uint64_t                        inode      = 0;
+            };
+
+            struct Delivery
+            {
+                WatchId       id;
+                Callback      callback;
+                ::std::string path;
+            };
+
+            ::std::map< ::std::string, WatchedFile >      m_files;
+            ::std::map< WatchId, ::std::string >          m_ids;         // Path of each watch
+            ::std::map< int32_t, uint32_t >               m_directories; // Files per inotify descriptor
+            WatchId                                       m_nextId;
+            WatchId                                       m_delivering;  // Watch whose callback is running
+            ::std::thread::id                             m_threadId;
+            int32_t                                       m_inotify;     // -1 when only polling
+            int32_t                                       m_wake;        // eventfd that interrupts the thread
+            uint32_t                                      m_pollMs;
+            uint32_t                                      m_debounceMs;
+            bool                                          m_stopping;
+            ::std::unique_ptr< Thread< FileWatcherCTX > > m_thread;
+
+            // These expect the lock to be held
+            void AddDescriptor( WatchedFile &a_file );
+            void RemoveDescriptor( int32_t a_descriptor );
+            bool Snapshot( WatchedFile &a_file );
+            void Mark( WatchedFile &a_file, Time a_now );
+            void ReadEvents();
+            bool Collect( bool a_poll, Time a_now, Time &a_next, ::std::vector< Delivery > &a_due );
+            void Wake();
+
+            static void *Run( void *a_context );
+
+        public:
+            /**
+             * @brief Create a watcher.
+             * @param a_pollMs Interval at which files that inotify cannot
+             *                 cover are checked; zero is treated as one.
+             * @param a_debounceMs Quiet time after an event before the file
+             *                     is checked; zero checks straight away.
+             * @note The background thread starts with the first Watch.
+             */
+            FileWatcher( uint32_t a_pollMs = 1000, uint32_t a_debounceMs = 50 );
+
+            /**
+             * @brief Stop the background thread and release every watch.
+             */
+            ~FileWatcher();
+
+            FileWatcher( const FileWatcher & ) = delete;
+            FileWatcher &operator =( const FileWatcher & ) = delete;
+
+            /**
+             * @brief Start watching a file.
+             * @details The file does not need to exist yet; its creation is
+             *          reported as a change.
+             * @param a_path Path of the file to watch.
+             * @param a_callback Called with a_path after each change.
+             * @return Watch id, or zero if the path or callback was empty or
+             *         the background thread could not be started.
+             */
+            WatchId Watch( const ::std::string &a_path, Callback &&a_callback );
+
+            /**
+             * @brief Stop watching a file.
+             * @details If the watch's callback is running on the watcher
+             *          thread, this waits for it to return (unless called
+             *          from that callback).
+             * @param a_id Watch id from Watch.
+             * @return True if the watch existed; false otherwise.
+             */
+            bool Unwatch( WatchId a_id );
+
+            /**
+             * @brief Check whether changes are delivered by inotify.
+             * @return True if inotify is in use; false if every file is
+             *         polled.
+             */
+            bool UsingInotify();
+
+            /**
+             * @brief Get the process-wide watcher.
+             * @details Created on first use and never destroyed, so objects
+             *          with static storage can still Unwatch while the
+             *          program exits.
+             * @return The shared watcher.
+             */
+            static FileWatcher &Shared();
+    };
+}
+
+#endif // _FILEWATCHER_HPP_
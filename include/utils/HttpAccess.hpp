@@ -12,10 +12,18 @@
 #define _HTTPACCESS_HPP_
 
 #include <utils/File.hpp>
+#include <utils/FileWatcher.hpp>
 #include <utils/Lockable.hpp>
 #include <utils/Types.hpp>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <map>
 #include <memory>
+#include <semaphore>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace utils
@@ -32,8 +40,30 @@ namespace utils
      *          resolved request path is provided, it will search for the first
      *          `.htaccess` file while traversing the directory tree toward `/`
      *          and restrict valid users to those listed (one user per line).
+     *
+     *          Successful credential checks are cached by a SHA-1 digest of
+     *          the encoded credentials, so a browser resending the same
+     *          header for every asset skips the password hash. Entries
+     *          expire after a TTL and are dropped when the credential file is
+     *          reloaded or access is reconfigured.
+     *
+     *          The `.htaccess` file governing a path, and its parsed user
+     *          set, are likewise cached per directory for a short TTL, so a
+     *          cached request is authorized without touching the filesystem.
+     *          Directories sharing a `.htaccess` file share one parsed list.
+     *
+     *          The htpasswd and `.htaccess` files are watched with
+     *          FileWatcher::Shared() rather than checked per request. A
+     *          changed file is parsed on the watcher's thread and the result
+     *          swapped in, so requests never stat it or wait for a reload.
+     * @note Thread-safe. Requests read the credential tables through an
+     *       atomic pointer and take only shared locks, so they proceed in
+     *       parallel; the exclusive lock is held just long enough to swap in
+     *       new tables or access lists. Password hashes are verified with
+     *       crypt_r and per-thread scratch space, and at most a configured
+     *       number run at once.
      */
-    class HttpAccess : public Lockable
+    class HttpAccess : public BasicLockable< SharedLockPolicy >
     {
         public:
             struct AuthResult
@@ -49,36 +79,101 @@ namespace utils
             };
 
         private:
+            // How a stored password is checked, decided once at load time
+            enum class Scheme : uint8_t
+            {
+                Sha,   // {SHA}: raw SHA-1 digest of the password
+                Plain, // {PLAIN}: the password itself
+                Crypt  // Anything else: crypt(3) hash, or legacy plain text
+            };
+
             struct Entry
             {
-                ::std::string user;
-                ::std::string pass;
+                Scheme        scheme;
+                ::std::string pass; // Digest bytes, password, or crypt hash
+            };
+
+            // Parsed htpasswd file; never modified once shared, a changed
+            // file is loaded into new tables
+            struct Tables
+            {
+                ::std::unordered_multimap< ::std::string, Entry > entries;        // By user name
+                uint64_t                                          generation = 0; // Keys the credential cache
+            };
+
+            // Parsed .htaccess file, immutable in the same way
+            struct AccessList
+            {
+                ::std::unordered_set< ::std::string > users;
+            };
+
+            struct CachedAccess
+            {
+                ::std::shared_ptr< const AccessList >   list; // Null when no .htaccess applies
+                ::std::chrono::steady_clock::time_point expires;
+                ::std::list< ::std::string >::iterator  position; // In AccessCache::order
+            };
+
+            // Entries share one TTL, so insertion order is also expiry order
+            // and the oldest entry is both the first stale and the one to evict
+            struct AccessCache : public BasicLockable< SharedLockPolicy >
+            {
+                ::std::unordered_map< ::std::string, CachedAccess > entries; // By directory, with a trailing '/'
+                ::std::list< ::std::string >                        order;   // Directories, oldest first
+                uint64_t                                            generation = 0; // Bumped when lists change
+                uint32_t                                            capacity   = 4096;
+                uint32_t                                            ttl        = 5; // Seconds
+            };
+
+            struct LastResult : public BasicLockable< SpinLockPolicy >
+            {
+                AuthResult result;
             };
 
-            ::std::vector< Entry >    m_entries;
+            struct CachedAuth
+            {
+                ::std::string                           user;
+                uint64_t                                generation;
+                ::std::chrono::steady_clock::time_point expires;
+                ::std::list< ::std::string >::iterator  position; // In AuthCache::order
+            };
+
+            // Ordered like AccessCache, for constant-time eviction
+            struct AuthCache : public BasicLockable< SharedLockPolicy >
+            {
+                ::std::unordered_map< ::std::string, CachedAuth > entries;
+                ::std::list< ::std::string >                      order; // Keys, oldest first
+                uint32_t                                          capacity = 1024;
+                uint32_t                                          ttl      = 300; // Seconds
+            };
+
+            ::std::atomic< ::std::shared_ptr< const Tables > > m_tables; // Null until the file loads
             ::std::string             m_file;
-            ::std::shared_ptr< File > m_fileHandle;
+            FileWatcher::WatchId      m_fileWatch;
             bool                      m_enabled;
-            bool                      m_loaded;
             ::std::string             m_realm;
-            AuthResult                m_lastAuth;
-            ::std::vector< ::std::string > m_accessUsers;
-            ::std::string                  m_accessFile;
-            ::std::shared_ptr< File >      m_accessHandle;
-            bool                           m_accessLoaded;
-
-            bool RefreshIfNeeded();
-            bool LoadEntries();
-            bool ParseEntry( const ::std::string &a_line );
-            bool CheckCredentials( const ::std::string &a_user, const ::std::string &a_pass );
-            bool RefreshAccessList( const ::std::string &a_path );
-            bool LoadAccessList();
+            ::std::map< ::std::string, ::std::shared_ptr< const AccessList > > m_accessLists;   // By .htaccess path
+            ::std::map< ::std::string, FileWatcher::WatchId >                 m_accessWatches; // By .htaccess path
+            LastResult                m_lastAuth;
+            AuthCache                 m_authCache;
+            AccessCache               m_accessCache;
+            uint64_t                  m_generation; // Last generation given to tables
+            ::std::shared_ptr< ::std::counting_semaphore<> > m_verifiers; // Limits concurrent crypt_r calls
+
+            // The helpers take locks themselves or touch no shared state.
+            void UnwatchAll();
+            void Reload( const ::std::string &a_path );
+            void ForgetAccessList( const ::std::string &a_accessPath );
+            bool FindCached( const ::std::string &a_key, uint64_t a_generation, ::std::string &a_user );
+            void StoreCached( const ::std::string &a_key, uint64_t a_generation, const ::std::string &a_user );
+            static ::std::shared_ptr< Tables > LoadTables( const ::std::string &a_path );
+            static bool ParseEntry( const ::std::string &a_line, Tables &a_tables );
+            bool CheckCredentials( const Tables &a_tables, const ::std::string &a_user, const ::std::string &a_pass );
+            bool VerifyPassword( const Entry &a_entry, const ::std::string &a_pass,
+                                 ::std::counting_semaphore<> *a_verifiers ) const;
+            bool ResolveAccessList( const ::std::string &a_path, ::std::shared_ptr< const AccessList > &a_list );
+            bool LoadAccessList( const ::std::string &a_accessPath, ::std::shared_ptr< const AccessList > &a_list );
             bool FindAccessFile( const ::std::string &a_path, ::std::string &a_accessPath ) const;
-            bool IsUserAllowed( const ::std::string &a_user ) const;
-            bool DecodeBase64( const ::std::string &a_input, ::std::string &a_output ) const;
-            int  Base64Value( char a_char ) const;
-            void Sha1( const uint8_t *a_data, size_t a_len, uint8_t a_output[ 20 ] ) const;
-            ::std::string Base64Encode( const uint8_t *a_data, size_t a_len ) const;
 
         public:
             /**
@@ -86,10 +181,29 @@ namespace utils
              */
             HttpAccess();
 
+            /**
+             * @brief Stop watching files; waits for a reload in progress.
+             */
+            ~HttpAccess();
+
+            HttpAccess( const HttpAccess & ) = delete;
+            HttpAccess &operator =( const HttpAccess & ) = delete;
+
             /**
              * @brief Configure access from an INI file.
-             * @details Reads the htpasswd path from [settings] access and an
-             *          optional realm from [settings] realm.
+             * @details Reads the htpasswd path from [settings] access, an
+             *          optional realm from [settings] realm, and the credential
+             *          cache size and TTL in seconds from [settings]
+             *          auth_cache and auth_cache_ttl (a size of zero disables
+             *          the cache). Cached credentials are discarded.
+             *          [settings] auth_concurrency caps how many crypt-style
+             *          hashes are verified at once (default: one per CPU).
+             *          [settings] access_cache and access_cache_ttl size the
+             *          per-directory `.htaccess` cache (default: 4096
+             *          directories for 5 seconds; zero checks the filesystem
+             *          every time).
+             *          The htpasswd file is loaded before this returns and
+             *          reloaded in the background whenever it changes.
              * @param a_ini INI file to read.
              * @return True if a path was configured; false otherwise.
              */
@@ -104,11 +218,25 @@ namespace utils
             /**
              * @brief Validate the Authorization header for a request.
              * @param a_request Request to inspect.
-             * @param a_path Optional resolved filesystem path for htaccess checks.
+             * @param a_path Optional resolved filesystem path for htaccess checks;
+             *               a directory ends in '/', as UriDecode resolves it.
              * @return True if authorized or access is disabled; false otherwise.
              */
             bool IsAuthorized( HttpRequest &a_request, const ::std::string &a_path = ::std::string() );
 
+            /**
+             * @brief Validate the Authorization header for a request.
+             * @details Unlike the two-argument form this does not touch the
+             *          shared last result, so concurrent callers each see
+             *          their own outcome.
+             * @param a_request Request to inspect.
+             * @param a_path Resolved filesystem path for htaccess checks; may
+             *               be empty. A directory ends in '/'.
+             * @param a_result Output structure describing the decision.
+             * @return True if authorized or access is disabled; false otherwise.
+             */
+            bool IsAuthorized( HttpRequest &a_request, const ::std::string &a_path, AuthResult &a_result );
+
             /**
              * @brief Respond with a 401 Unauthorized challenge.
              * @param a_socket Socket to send the response to.
@@ -118,6 +246,8 @@ namespace utils
 
             /**
              * @brief Retrieve the most recent authorization result.
+             * @details Reflects the last two-argument IsAuthorized call made
+             *          by any thread.
              * @param a_result Output structure populated with the last result.
              */
             void GetLastResult( AuthResult &a_result );
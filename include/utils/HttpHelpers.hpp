@@ -11,6 +11,7 @@
 #define _HTTPHELPERS_HPP_
 
 #include <utils/Types.hpp>
+#include <stddef.h>
 #include <string>
 
 namespace utils
@@ -45,6 +46,14 @@ namespace utils
              */
             static ::std::string HtmlEscape( const ::std::string &a_string );
 
+            /**
+             * @brief HTML-escape text and append it to a string.
+             * @param a_string Source text to escape.
+             * @param a_len Length of a_string in bytes.
+             * @param a_output String the escaped text is appended to.
+             */
+            static void          HtmlEscape( const char *a_string, size_t a_len, ::std::string &a_output );
+
             /**
              * @brief URI-encode a string.
              * @param a_string Source string to encode.
@@ -52,6 +61,37 @@ namespace utils
              */
             static ::std::string UriEncode( const ::std::string &a_string );
 
+            /**
+             * @brief URI-encode text and append it to a string.
+             * @param a_string Source text to encode.
+             * @param a_len Length of a_string in bytes.
+             * @param a_output String the encoded text is appended to.
+             */
+            static void          UriEncode( const char *a_string, size_t a_len, ::std::string &a_output );
+
+            /**
+             * @brief Escape text for a JSON string and append it to a string.
+             * @details Quotes, backslashes, and control characters are
+             *          escaped and well-formed UTF-8 is copied as it is. Each
+             *          byte that is not part of a well-formed UTF-8 sequence
+             *          becomes U+FFFD, so the output is always valid JSON.
+             * @param a_string Source text to escape.
+             * @param a_len Length of a_string in bytes.
+             * @param a_output String the escaped text is appended to.
+             */
+            static void          JsonEscape( const char *a_string, size_t a_len, ::std::string &a_output );
+
+            /**
+             * @brief Get the quality an Accept header gives a media type.
+             * @details The most specific matching range decides: the
+             *          exact type, then its type's wildcard, then the full
+             *          wildcard. A range without a q parameter has quality 1.
+             * @param a_accept Accept header value.
+             * @param a_type Lowercase media type, e.g. "text/html".
+             * @return Quality from 0 to 1; 0 if no range matches.
+             */
+            static double        AcceptQuality( const ::std::string &a_accept, const ::std::string &a_type );
+
             /**
              * @brief URI-decode a string.
              * @param a_string Source string to decode.
@@ -15,6 +15,7 @@
 #include <utils/LogFile.hpp>
 #include <utils/Socket.hpp>
 #include <utils/Types.hpp>
+#include <chrono>
 #include <string>
 
 namespace utils
@@ -26,9 +27,17 @@ namespace utils
      *          HTTP compliance; limits and behavior are determined by the
      *          underlying implementation and configuration.
      * @note Not safe for concurrent access without external synchronization.
+     *       Requests are confined to the thread serving the connection, so
+     *       they carry no lock of their own.
      */
-    class HttpRequest : public Lockable
+    class HttpRequest : public BasicLockable< NoLockPolicy >
     {
+        public:
+            /**
+             * @brief Header list node; owned by the request and unlocked.
+             */
+            typedef KeyValuePair< ::std::string, ::std::string, NoLockPolicy > Header;
+
         private:
             ::std::string m_method;
             ::std::string m_uri;
@@ -42,10 +51,18 @@ namespace utils
             bool          m_sset; // If true, then m_start was assigned a value
             bool          m_eset; // If true, then m_end was assigned a value
             bool          m_timeout;
-            ::std::shared_ptr< KeyValuePair< ::std::string, ::std::string > > m_meta;
+            uint32_t      m_headerTimeout; // Milliseconds allowed for the request line and headers
+            uint32_t      m_bodyTimeout;   // Milliseconds allowed for the body
+            uint32_t      m_idleTimeout;   // Milliseconds allowed between received segments
+            ::std::shared_ptr< Header > m_meta;
             ::std::string m_response;
             ::std::string m_lasterror;
 
+            // Wait for and append the next received segment, or fail at a deadline
+            bool Fill( Socket &a_socket, ::std::string &a_pending,
+                       ::std::chrono::steady_clock::time_point a_deadline,
+                       ::std::chrono::steady_clock::time_point &a_lastRead );
+
         public:
             /**
              * @brief Construct a new empty request.
@@ -68,6 +85,22 @@ namespace utils
              */
             ::std::string &Uri();
 
+            /**
+             * @brief Get the request URI without its query string.
+             * @details A '?' directly after a '.' is kept, since it names an
+             *          internal operation (e.g. "/ip.?").
+             * @return URI up to the query string.
+             */
+            ::std::string  Path();
+
+            /**
+             * @brief Retrieve a query string parameter.
+             * @param a_key Parameter name; matched exactly.
+             * @param a_value Output value, URI-decoded.
+             * @return True if the parameter is present; false otherwise.
+             */
+            bool           QueryValue( const ::std::string &a_key, ::std::string &a_value );
+
             /**
              * @brief Access the request method.
              * @return Mutable reference to the method string.
@@ -84,7 +117,7 @@ namespace utils
              * @brief Access the metadata header list.
              * @return Shared pointer to key/value metadata storage.
              */
-            ::std::shared_ptr< KeyValuePair< ::std::string, ::std::string > > &Meta();
+            ::std::shared_ptr< Header > &Meta();
 
             /**
              * @brief Retrieve the Host header value.
@@ -132,6 +165,26 @@ namespace utils
              */
             bool    Read( ::std::shared_ptr< Socket > &a_socket );
 
+            /**
+             * @brief Set the deadlines Read enforces.
+             * @details The header deadline runs from the start of Read until
+             *          the blank line ending the headers; the body deadline
+             *          then runs until Content-Length bytes have arrived. The
+             *          idle timeout cuts off a client that sends nothing for
+             *          that long at any point. Read blocks in poll() between
+             *          segments, so a slow client costs no CPU while waiting.
+             * @param a_headerMs Header deadline in milliseconds; zero keeps the current value.
+             * @param a_bodyMs Body deadline in milliseconds; zero keeps the current value.
+             * @param a_idleMs Idle timeout in milliseconds; zero keeps the current value.
+             */
+            void    SetTimeouts( uint32_t a_headerMs, uint32_t a_bodyMs, uint32_t a_idleMs );
+
+            /**
+             * @brief Check whether the last Read stopped at a deadline.
+             * @return True if Read timed out; false otherwise.
+             */
+            bool    TimedOut() const;
+
             /**
              * @brief Send a file response for the current request.
              * @param a_socket Socket to write to; must be non-null and connected.
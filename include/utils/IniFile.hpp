@@ -19,16 +19,22 @@
 
 namespace utils
 {
+    /**
+     * @brief INI entry list node; guarded by the owning IniFileHeading.
+     */
+    typedef KeyValuePair< ::std::string, ::std::string, NoLockPolicy > IniFileEntry;
+
     /**
      * @brief Represents a single INI section and its key/value entries.
      * @details Stores the section name and a linked list of entries.
-     * @note Not safe for concurrent access without external synchronization.
+     * @note Not safe for concurrent access without external synchronization;
+     *       sections owned by an IniFile are guarded by the IniFile lock.
      */
-    class IniFileHeading : public Lockable
+    class IniFileHeading : public BasicLockable< NoLockPolicy >
     {
         private:
             ::std::string                                                     m_name;
-            ::std::shared_ptr< KeyValuePair< ::std::string, ::std::string > > m_entries;
+            ::std::shared_ptr< IniFileEntry >                                 m_entries;
             ::std::shared_ptr< IniFileHeading >                               m_next;
 
         public:
@@ -53,7 +59,7 @@ namespace utils
              * @brief Access the head of the entries list.
              * @return Shared pointer to the first entry.
              */
-            ::std::shared_ptr< KeyValuePair< ::std::string, ::std::string > > &Entries();
+            ::std::shared_ptr< IniFileEntry >                                 &Entries();
 
             /**
              * @brief Access the next section in the linked list.
@@ -81,19 +87,25 @@ namespace utils
     /**
      * @brief INI file parser and writer.
      * @details Loads and caches INI content from disk, exposing read/write
-     *          helpers for sectioned key/value data.
-     * @note Not safe for concurrent access without external synchronization.
+     *          helpers for sectioned key/value data. The file is watched
+     *          with FileWatcher::Shared(), so reads only look at the disk
+     *          (and reload) after it reports a change.
+     * @note Thread-safe. Reads take a shared lock and run in parallel; only
+     *       writes and reloads after an on-disk change take the exclusive
+     *       lock.
      */
-    class IniFile : public Lockable
+    class IniFile : public BasicLockable< SharedLockPolicy >
     {
         private:
             File                                m_file;
             uint32_t                            m_modTime;
             ::std::shared_ptr< IniFileHeading > m_heading;
-            bool                                m_loading;
 
+            // The helpers below expect the caller to hold the lock.
             void LoadFile();
             void SaveFile();
+            bool Find( const char *a_heading, const char *a_name, ::std::string &a_value );
+            bool Store( const char *a_heading, const char *a_name, const char *a_value, bool &a_changed );
 
         public:
             /**
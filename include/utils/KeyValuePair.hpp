@@ -19,20 +19,22 @@
 
 namespace utils
 {
-    template< typename key_type, typename value_type >
+    template< typename key_type, typename value_type, typename policy = RecursiveLockPolicy >
 
     /**
      * @brief Simple linked key/value pair node.
      * @details Stores a key, a value, and a next pointer to form a linked list.
      *          Accessors acquire a lock for basic thread-safety, but callers
-     *          should still synchronize when iterating across nodes.
+     *          should still synchronize when iterating across nodes. Lists
+     *          owned by a single thread or guarded by their owner can use
+     *          NoLockPolicy to skip the per-node mutex.
      */
-    class KeyValuePair : public Lockable
+    class KeyValuePair : public BasicLockable< policy >
     {
         private:
             key_type   m_key;
             value_type m_value;
-            ::std::shared_ptr< KeyValuePair< key_type, value_type > > m_next;
+            ::std::shared_ptr< KeyValuePair< key_type, value_type, policy > > m_next;
 
         public:
             /**
@@ -78,7 +80,7 @@ namespace utils
              * @brief Access the next node in the list.
              * @return Shared pointer to the next node.
              */
-            ::std::shared_ptr< KeyValuePair< key_type, value_type > > &Next()
+            ::std::shared_ptr< KeyValuePair< key_type, value_type, policy > > &Next()
             {
                 ::utils::Lock lock( this );
                 return m_next;
@@ -91,7 +93,7 @@ namespace utils
              */
             void ToJson( ::std::string &a_json )
             {
-                ::std::shared_ptr< KeyValuePair< key_type, value_type > > meta = this;
+                ::std::shared_ptr< KeyValuePair< key_type, value_type, policy > > meta = this;
                 ::std::string temp;
                 a_json += "{";
                 while( meta )
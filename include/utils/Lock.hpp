@@ -1,6 +1,6 @@
 /**
     Lock.hpp : Lock class definition
-    Description: Mutex lock wrapper for thread safety.
+    Description: Exclusive and shared lock guards for thread safety.
     Copyright 2014-2026 Daniel Wilson
     SPDX-License-Identifier: MIT
 */
@@ -12,32 +12,163 @@
 
 #include <utils/Types.hpp>
 #include <utils/Lockable.hpp>
+#include <source_location>
+
+#if defined( UTILS_LOCK_PROFILING )
+#include <utils/LockProfiler.hpp>
+#include <typeinfo>
+#endif
 
 namespace utils
 {
     /**
      * @brief RAII guard for Lockable objects.
-     * @details Locks the provided Lockable in the constructor and releases it
-     *          in the destructor.
+     * @details Locks the provided object in the constructor and releases it
+     *          in the destructor. Works with any BasicLockable policy; for
+     *          NoLockPolicy objects the guard does nothing.
      * @note The provided Lockable pointer must remain valid for the guard's
-     *       lifetime.
+     *       lifetime. When built with UTILS_LOCK_PROFILING each acquisition is
+     *       recorded in LockProfiler.
      */
     class Lock
     {
         private:
-            Lockable *m_object;
+            const void  *m_object;
+            void       ( *m_release )( const void * );
+#if defined( UTILS_LOCK_PROFILING )
+            uint32_t     m_site;
+            uint64_t     m_acquired;
+#endif
+
+            template< typename policy >
+            static void Release( const void *a_object ) noexcept
+            {
+                static_cast< const BasicLockable< policy > * >( a_object )->Unlock();
+            }
 
         public:
             /**
              * @brief Acquire a lock on the given Lockable object.
-             * @param a_object Lockable instance to guard; must be non-null.
+             * @param a_object Lockable instance to guard; may be null.
+             * @param a_location Call site recorded when lock profiling is
+             *                   compiled in; leave defaulted.
              */
-            Lock( Lockable *a_object );
+            template< typename policy >
+            Lock( const BasicLockable< policy > *a_object,
+                  const ::std::source_location &a_location = ::std::source_location::current() )
+            : m_object( a_object )
+            , m_release( nullptr )
+            {
+                UNUSED( a_location );
+                if constexpr( policy::Enabled )
+                {
+                    if( nullptr != a_object )
+                    {
+#if defined( UTILS_LOCK_PROFILING )
+                        m_site = LockProfiler::Register( typeid( *a_object ).name(), a_location, false );
+                        uint64_t start = LockProfiler::Now();
+                        a_object->Lock();
+                        m_acquired = LockProfiler::Now();
+                        LockProfiler::Acquired( m_site, m_acquired - start );
+#else
+                        a_object->Lock();
+#endif
+                        m_release = &Release< policy >;
+                    }
+                }
+            }
+
+            Lock( const Lock & ) = delete;
+            Lock &operator =( const Lock & ) = delete;
 
             /**
              * @brief Release the lock held on the Lockable object.
              */
-            ~Lock();
+            ~Lock()
+            {
+                if( nullptr != m_release )
+                {
+#if defined( UTILS_LOCK_PROFILING )
+                    LockProfiler::Released( m_site, LockProfiler::Now() - m_acquired );
+#endif
+                    m_release( m_object );
+                }
+            }
+    };
+
+    /**
+     * @brief RAII guard taking shared (reader) access to a Lockable object.
+     * @details Multiple SharedLock holders may proceed concurrently on a
+     *          SharedLockPolicy object while excluding any utils::Lock holder.
+     *          For policies without a shared mode the guard takes the
+     *          exclusive lock instead.
+     * @note Shared locks are not recursive and cannot be upgraded; release the
+     *       SharedLock before taking a Lock on the same object.
+     */
+    class SharedLock
+    {
+        private:
+            const void  *m_object;
+            void       ( *m_release )( const void * );
+#if defined( UTILS_LOCK_PROFILING )
+            uint32_t     m_site;
+            uint64_t     m_acquired;
+#endif
+
+            template< typename policy >
+            static void Release( const void *a_object ) noexcept
+            {
+                static_cast< const BasicLockable< policy > * >( a_object )->UnlockShared();
+            }
+
+        public:
+            /**
+             * @brief Acquire shared access to the given Lockable object.
+             * @param a_object Lockable instance to guard; may be null.
+             * @param a_location Call site recorded when lock profiling is
+             *                   compiled in; leave defaulted.
+             */
+            template< typename policy >
+            SharedLock( const BasicLockable< policy > *a_object,
+                        const ::std::source_location &a_location = ::std::source_location::current() )
+            : m_object( a_object )
+            , m_release( nullptr )
+            {
+                UNUSED( a_location );
+                if constexpr( policy::Enabled )
+                {
+                    if( nullptr != a_object )
+                    {
+#if defined( UTILS_LOCK_PROFILING )
+                        m_site = LockProfiler::Register( typeid( *a_object ).name(), a_location, true );
+                        uint64_t start = LockProfiler::Now();
+                        a_object->LockShared();
+                        m_acquired = LockProfiler::Now();
+                        LockProfiler::Acquired( m_site, m_acquired - start );
+#else
+                        a_object->LockShared();
+#endif
+                        m_release = &Release< policy >;
+                    }
+                }
+            }
+
+            SharedLock( const SharedLock & ) = delete;
+            SharedLock &operator =( const SharedLock & ) = delete;
+
+            /**
+             * @brief Release the shared lock held on the Lockable object.
+             */
+            ~SharedLock()
+            {
+                if( nullptr != m_release )
+                {
+#if defined( UTILS_LOCK_PROFILING )
+                    LockProfiler::Released( m_site, LockProfiler::Now() - m_acquired );
+#endif
+                    m_release( m_object );
+                }
+            }
     };
 }
 
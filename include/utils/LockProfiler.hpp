@@ -0,0 +1,118 @@
+/**
+    LockProfiler.hpp : LockProfiler class definition
+    Description: Per-call-site lock contention statistics.
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#pragma once
+
+#ifndef _LOCKPROFILER_HPP_
+#define _LOCKPROFILER_HPP_
+
+#include <utils/Types.hpp>
+#include <source_location>
+#include <string>
+#include <vector>
+
+namespace utils
+{
+    /**
+     * @brief Records lock wait/hold statistics per lock site.
+     * @details When the library and program are built with
+     *          UTILS_LOCK_PROFILING defined (`make LOCKPROFILE=1`), Lock and
+     *          SharedLock register every acquisition here. A site is the
+     *          dynamic type of the guarded object plus the source location of
+     *          the guard, so the same class locked from different functions
+     *          is reported separately. Without the define the guards contain
+     *          no profiling code and the table stays empty.
+     * @note Thread-safe; recording is lock-free and never allocates. Once the
+     *       fixed-size site table is full, new sites are silently dropped.
+     */
+    class LockProfiler
+    {
+        public:
+            /**
+             * @brief Snapshot of the statistics for one lock site.
+             */
+            struct Site
+            {
+                const char *type;
+                const char *file;
+                const char *function;
+                uint32_t    line;
+                bool        shared;
+                uint64_t    count;
+                uint64_t    waitNs;
+                uint64_t    maxWaitNs;
+                uint64_t    holdNs;
+                uint64_t    maxHoldNs;
+            };
+
+            /**
+             * @brief Slot value returned when a site could not be registered.
+             */
+            static constexpr uint32_t InvalidSite = 0xFFFFFFFF;
+
+            /**
+             * @brief Check whether profiling was compiled in.
+             * @return True when built with UTILS_LOCK_PROFILING.
+             */
+            static constexpr bool Enabled()
+            {
+#if defined( UTILS_LOCK_PROFILING )
+                return true;
+#else
+                return false;
+#endif
+            }
+
+            /**
+             * @brief Find or create the table slot for a lock site.
+             * @param a_type Mangled type name of the guarded object.
+             * @param a_location Source location of the guard.
+             * @param a_shared True for shared (reader) acquisitions.
+             * @return Slot index, or InvalidSite if the table is full.
+             */
+            static uint32_t Register( const char *a_type, const ::std::source_location &a_location, bool a_shared );
+
+            /**
+             * @brief Record a completed acquisition.
+             * @param a_site Slot returned by Register.
+             * @param a_waitNs Time spent waiting for the lock.
+             */
+            static void Acquired( uint32_t a_site, uint64_t a_waitNs );
+
+            /**
+             * @brief Record a release.
+             * @param a_site Slot returned by Register.
+             * @param a_holdNs Time the lock was held.
+             */
+            static void Released( uint32_t a_site, uint64_t a_holdNs );
+
+            /**
+             * @brief Read the monotonic clock.
+             * @return Nanoseconds from an arbitrary fixed point.
+             */
+            static uint64_t Now();
+
+            /**
+             * @brief Copy the statistics of every registered site.
+             * @param a_sites Output list; replaced, not appended to.
+             */
+            static void Snapshot( ::std::vector< Site > &a_sites );
+
+            /**
+             * @brief Append a plain-text report sorted by total wait time.
+             * @param a_output String the report is appended to.
+             */
+            static void Report( ::std::string &a_output );
+
+            /**
+             * @brief Zero all counters; registered sites are kept.
+             */
+            static void Reset();
+    };
+}
+
+#endif // _LOCKPROFILER_HPP_
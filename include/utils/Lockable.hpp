@@ -11,40 +11,229 @@
 #define _LOCKABLE_HPP_
 
 #include <utils/Types.hpp>
+#include <atomic>
+#include <exception>
 #include <mutex>
+#include <shared_mutex>
+#include <thread>
 
 namespace utils
 {
     /**
-     * @brief Base class providing a recursive mutex for derived types.
+     * @brief Lock policy that performs no synchronization.
+     * @details Intended for thread-confined objects. The policy has no state,
+     *          so it adds no storage to the owning object and locking through
+     *          it compiles away.
+     */
+    struct NoLockPolicy
+    {
+        static constexpr bool Enabled = false;
+        static constexpr bool Shared  = false;
+
+        void Lock() noexcept {}
+        void Unlock() noexcept {}
+    };
+
+    /**
+     * @brief Lock policy backed by a test-and-set spinlock.
+     * @details Suited to very short critical sections on small objects.
+     * @note Not recursive; a thread must not lock the same object twice.
+     */
+    struct SpinLockPolicy
+    {
+        static constexpr bool Enabled = true;
+        static constexpr bool Shared  = false;
+
+        ::std::atomic_flag m_flag;
+
+        void Lock() noexcept
+        {
+            uint32_t spins = 0;
+            while( m_flag.test_and_set( ::std::memory_order_acquire ) )
+            {
+                while( m_flag.test( ::std::memory_order_relaxed ) )
+                {
+                    if( ++spins < 64 )
+                    {
+#if defined( __x86_64__ ) || defined( __i386__ )
+                        __builtin_ia32_pause();
+#endif
+                    }
+                    else
+                    {
+                        ::std::this_thread::yield();
+                    }
+                }
+            }
+        }
+
+        void Unlock() noexcept
+        {
+            m_flag.clear( ::std::memory_order_release );
+        }
+    };
+
+    /**
+     * @brief Lock policy backed by a recursive mutex.
+     * @details Default policy; allows a thread to re-enter its own locks.
+     */
+    struct RecursiveLockPolicy
+    {
+        static constexpr bool Enabled = true;
+        static constexpr bool Shared  = false;
+
+        ::std::recursive_mutex m_mutex;
+
+        void Lock() noexcept
+        {
+            try
+            {
+                m_mutex.lock();
+            }
+            catch( const ::std::exception &e )
+            {
+                UNUSED( e );
+            }
+        }
+
+        void Unlock() noexcept
+        {
+            m_mutex.unlock();
+        }
+    };
+
+    /**
+     * @brief Lock policy backed by a reader/writer mutex.
+     * @details Supports exclusive locking through Lock and shared locking
+     *          through SharedLock.
+     * @note Not recursive in either mode.
+     */
+    struct SharedLockPolicy
+    {
+        static constexpr bool Enabled = true;
+        static constexpr bool Shared  = true;
+
+        ::std::shared_mutex m_mutex;
+
+        void Lock() noexcept
+        {
+            try
+            {
+                m_mutex.lock();
+            }
+            catch( const ::std::exception &e )
+            {
+                UNUSED( e );
+            }
+        }
+
+        void Unlock() noexcept
+        {
+            m_mutex.unlock();
+        }
+
+        void LockShared() noexcept
+        {
+            try
+            {
+                m_mutex.lock_shared();
+            }
+            catch( const ::std::exception &e )
+            {
+                UNUSED( e );
+            }
+        }
+
+        void UnlockShared() noexcept
+        {
+            m_mutex.unlock_shared();
+        }
+    };
+
+    template< typename policy >
+
+    /**
+     * @brief Base class providing a policy-selected lock for derived types.
      * @details Derived classes can use Lock to guard critical sections.
-     *          Lock/Unlock are protected to enforce RAII usage.
+     *          Lock/Unlock are protected to enforce RAII usage. The policy
+     *          decides the synchronization primitive (and its footprint):
+     *          NoLockPolicy, SpinLockPolicy, RecursiveLockPolicy, or
+     *          SharedLockPolicy.
      */
-    class Lockable
+    class BasicLockable
     {
         private:
-            mutable ::std::recursive_mutex m_mutex;
+            [[no_unique_address]] mutable policy m_policy;
 
         protected:
             /**
              * @brief Virtual destructor for proper cleanup in derived classes.
              */
-            virtual ~Lockable() {};
+            virtual ~BasicLockable() {};
 
             /**
-             * @brief Acquire the recursive mutex.
+             * @brief Acquire the lock exclusively.
              * @note Intended for use by utils::Lock.
              */
-            void Lock() noexcept;
+            void Lock() const noexcept
+            {
+                m_policy.Lock();
+            }
 
             /**
-             * @brief Release the recursive mutex.
+             * @brief Release an exclusive lock.
              * @note Intended for use by utils::Lock.
              */
-            void Unlock() noexcept;
+            void Unlock() const noexcept
+            {
+                m_policy.Unlock();
+            }
+
+            /**
+             * @brief Acquire the lock for shared (read) access.
+             * @details Policies without a shared mode fall back to the
+             *          exclusive lock.
+             * @note Intended for use by utils::SharedLock.
+             */
+            void LockShared() const noexcept
+            {
+                if constexpr( policy::Shared )
+                {
+                    m_policy.LockShared();
+                }
+                else
+                {
+                    m_policy.Lock();
+                }
+            }
+
+            /**
+             * @brief Release a shared lock.
+             * @note Intended for use by utils::SharedLock.
+             */
+            void UnlockShared() const noexcept
+            {
+                if constexpr( policy::Shared )
+                {
+                    m_policy.UnlockShared();
+                }
+                else
+                {
+                    m_policy.Unlock();
+                }
+            }
 
         friend class Lock;
+        friend class SharedLock;
     };
+
+    /**
+     * @brief Base class providing a recursive mutex for derived types.
+     * @details This is the default used throughout the library; thread
+     *          confined types can derive from BasicLockable< NoLockPolicy >
+     *          instead to drop the mutex entirely.
+     */
+    typedef BasicLockable< RecursiveLockPolicy > Lockable;
 }
 
 #endif // _LOCKABLE_HPP_
@@ -0,0 +1,234 @@
+/**
+    MpmcQueue.hpp : MpmcQueue class definition
+    Description: Bounded lock-free multi-producer/multi-consumer queue.
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#pragma once
+
+#ifndef _MPMCQUEUE_HPP_
+#define _MPMCQUEUE_HPP_
+
+#include <utils/Types.hpp>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <stddef.h>
+#include <utility>
+
+namespace utils
+{
+    template< typename type >
+
+    /**
+     * @brief Bounded lock-free queue for any number of producers and consumers.
+     * @details A fixed ring of cells, each tagged with a sequence number that
+     *          tells producers and consumers whether the cell is free or full
+     *          for their ticket (D. Vyukov's bounded MPMC design). All storage
+     *          is allocated in the constructor; Enqueue and Dequeue never
+     *          allocate, and values are moved in and out of the ring so
+     *          handing over a shared_ptr costs no reference-count churn.
+     *          Push/Pop are FIFO aliases of Enqueue/Dequeue so the queue can
+     *          stand in for a Staque used as a queue.
+     * @note Thread-safe and lock-free. Length is a snapshot and may be stale
+     *       by the time it is read.
+     */
+    class MpmcQueue
+    {
+        private:
+            static constexpr size_t CacheLine = 64;
+
+            struct Cell
+            {
+                ::std::atomic< size_t > sequence;
+                alignas( type ) unsigned char storage[ sizeof( type ) ];
+            };
+
+            ::std::unique_ptr< Cell[] >                  m_cells;
+            size_t                                       m_mask;
+            alignas( CacheLine ) ::std::atomic< size_t > m_enqueuePos;
+            alignas( CacheLine ) ::std::atomic< size_t > m_dequeuePos;
+
+            template< typename value >
+            bool Insert( value &&a_value )
+            {
+                Cell  *cell     = nullptr;
+                size_t position = m_enqueuePos.load( ::std::memory_order_relaxed );
+                while( true )
+                {
+                    cell = &( m_cells[ position & m_mask ] );
+                    size_t   sequence = cell->sequence.load( ::std::memory_order_acquire );
+                    intptr_t diff     = static_cast< intptr_t >( sequence ) - static_cast< intptr_t >( position );
+                    if( 0 == diff )
+                    {
+                        if( m_enqueuePos.compare_exchange_weak( position, position + 1, ::std::memory_order_relaxed ) )
+                        {
+                            break;
+                        }
+                    }
+                    else if( diff < 0 )
+                    {
+                        // Full
+                        return false;
+                    }
+                    else
+                    {
+                        position = m_enqueuePos.load( ::std::memory_order_relaxed );
+                    }
+                }
+                new( cell->storage ) type( ::std::forward< value >( a_value ) );
+                cell->sequence.store( position + 1, ::std::memory_order_release );
+                return true;
+            }
+
+        public:
+            /**
+             * @brief Construct a queue with room for at least a_capacity values.
+             * @param a_capacity Requested capacity; rounded up to a power of two
+             *                   (minimum 2).
+             */
+            MpmcQueue( size_t a_capacity )
+            : m_cells()
+            , m_mask( 0 )
+            , m_enqueuePos( 0 )
+            , m_dequeuePos( 0 )
+            {
+                size_t capacity = 2;
+                while( capacity < a_capacity )
+                {
+                    capacity <<= 1;
+                }
+                m_cells = ::std::unique_ptr< Cell[] >( new Cell[ capacity ] );
+                m_mask  = capacity - 1;
+                for( size_t i = 0; i < capacity; ++i )
+                {
+                    m_cells[ i ].sequence.store( i, ::std::memory_order_relaxed );
+                }
+            }
+
+            MpmcQueue( const MpmcQueue & ) = delete;
+            MpmcQueue &operator =( const MpmcQueue & ) = delete;
+
+            /**
+             * @brief Destroy the queue and any values still in it.
+             * @note No other thread may use the queue while it is destroyed.
+             */
+            ~MpmcQueue()
+            {
+                size_t end = m_enqueuePos.load( ::std::memory_order_acquire );
+                for( size_t position = m_dequeuePos.load( ::std::memory_order_acquire ); position != end; ++position )
+                {
+                    Cell &cell = m_cells[ position & m_mask ];
+                    if( cell.sequence.load( ::std::memory_order_acquire ) == ( position + 1 ) )
+                    {
+                        ::std::launder( reinterpret_cast< type * >( cell.storage ) )->~type();
+                    }
+                }
+            }
+
+            /**
+             * @brief Get the number of slots in the ring.
+             * @return Capacity after rounding.
+             */
+            size_t Capacity() const
+            {
+                return m_mask + 1;
+            }
+
+            /**
+             * @brief Get the approximate number of queued values.
+             * @return Snapshot of the element count.
+             */
+            size_t Length() const
+            {
+                size_t enqueued = m_enqueuePos.load( ::std::memory_order_acquire );
+                size_t dequeued = m_dequeuePos.load( ::std::memory_order_acquire );
+                return ( enqueued > dequeued ) ? ( enqueued - dequeued ) : 0;
+            }
+
+            /**
+             * @brief Enqueue a copy of a value at the back.
+             * @param a_value Value to copy into the queue.
+             * @return True if queued; false if the queue is full.
+             */
+            bool Enqueue( const type &a_value )
+            {
+                return Insert( a_value );
+            }
+
+            /**
+             * @brief Enqueue a value at the back by moving it.
+             * @param a_value Value to move into the queue; unchanged on failure.
+             * @return True if queued; false if the queue is full.
+             */
+            bool Enqueue( type &&a_value )
+            {
+                return Insert( ::std::move( a_value ) );
+            }
+
+            /**
+             * @brief Dequeue the value at the front.
+             * @param a_value Output value; the element is moved into it.
+             * @return True if a value was removed; false if the queue is empty.
+             */
+            bool Dequeue( type &a_value )
+            {
+                Cell  *cell     = nullptr;
+                size_t position = m_dequeuePos.load( ::std::memory_order_relaxed );
+                while( true )
+                {
+                    cell = &( m_cells[ position & m_mask ] );
+                    size_t   sequence = cell->sequence.load( ::std::memory_order_acquire );
+                    intptr_t diff     = static_cast< intptr_t >( sequence ) - static_cast< intptr_t >( position + 1 );
+                    if( 0 == diff )
+                    {
+                        if( m_dequeuePos.compare_exchange_weak( position, position + 1, ::std::memory_order_relaxed ) )
+                        {
+                            break;
+                        }
+                    }
+                    else if( diff < 0 )
+                    {
+                        // Empty
+                        return false;
+                    }
+                    else
+                    {
+                        position = m_dequeuePos.load( ::std::memory_order_relaxed );
+                    }
+                }
+                type *stored = ::std::launder( reinterpret_cast< type * >( cell->storage ) );
+                a_value = ::std::move( *stored );
+                stored->~type();
+                cell->sequence.store( position + m_mask + 1, ::std::memory_order_release );
+                return true;
+            }
+
+            /**
+             * @brief Alias of Enqueue( const type & ); the queue is FIFO only.
+             */
+            bool Push( const type &a_value )
+            {
+                return Enqueue( a_value );
+            }
+
+            /**
+             * @brief Alias of Enqueue( type && ); the queue is FIFO only.
+             */
+            bool Push( type &&a_value )
+            {
+                return Enqueue( ::std::move( a_value ) );
+            }
+
+            /**
+             * @brief Alias of Dequeue; removes the oldest value.
+             */
+            bool Pop( type &a_value )
+            {
+                return Dequeue( a_value );
+            }
+    };
+}
+
+#endif // _MPMCQUEUE_HPP_
@@ -0,0 +1,105 @@
+/**
+    RateLimiter.hpp : RateLimiter class definition
+    Description: Per-client token buckets and connection counts.
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#pragma once
+
+#ifndef _RATELIMITER_HPP_
+#define _RATELIMITER_HPP_
+
+#include <utils/Types.hpp>
+#include <utils/Lockable.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace utils
+{
+    /**
+     * @brief Per-client request rate and concurrent connection limits.
+     * @details Each client (typically its address) gets a token bucket that
+     *          refills at a fixed rate up to a burst size, plus a count of
+     *          its open connections. State lives in a fixed-size table split
+     *          into shards, each an open-addressed array guarded by its own
+     *          spin lock, so clients hashing to different shards never
+     *          contend. Entries age out: a slot whose client has no open
+     *          connections and a full bucket is indistinguishable from a new
+     *          client and is reused for one.
+     * @note Thread-safe. Client keys are stored as 64-bit hashes. If a shard
+     *       has no reusable slot in a new client's probe window, that client
+     *       is allowed through untracked rather than refused.
+     */
+    class RateLimiter
+    {
+        private:
+            struct Entry
+            {
+                uint64_t key         = 0; // Zero marks a never-used slot
+                uint64_t stamp       = 0; // Milliseconds at the last refill
+                float    tokens      = 0;
+                uint32_t connections = 0;
+            };
+
+            struct alignas( 64 ) Shard : public BasicLockable< SpinLockPolicy >
+            {
+                ::std::vector< Entry > entries;
+            };
+
+            ::std::unique_ptr< Shard[] > m_shards;
+            uint32_t                     m_shardCount;
+            uint32_t                     m_mask;        // Entries per shard - 1
+            double                       m_rate;        // Tokens per millisecond
+            double                       m_burst;
+            uint32_t                     m_connections;
+
+            static uint64_t Hash( const ::std::string &a_client );
+            static uint64_t Now();
+            Entry *Find( Shard &a_shard, uint64_t a_key, uint64_t a_now, bool a_create );
+            void   Refill( Entry &a_entry, uint64_t a_now ) const;
+
+        public:
+            /**
+             * @brief Create a limiter.
+             * @param a_rate Requests per second allowed per client; zero
+             *               disables the request limit.
+             * @param a_burst Requests a client may make at once after being
+             *                idle; values below one are treated as one.
+             * @param a_connections Concurrent connections allowed per client;
+             *                      zero disables the connection limit.
+             * @param a_capacity Clients tracked at once, rounded up to a
+             *                   power of two per shard.
+             */
+            RateLimiter( double a_rate, double a_burst, uint32_t a_connections, uint32_t a_capacity = 4096 );
+
+            RateLimiter( const RateLimiter & ) = delete;
+            RateLimiter &operator =( const RateLimiter & ) = delete;
+
+            /**
+             * @brief Count a new connection from a client.
+             * @param a_client Client key, such as its address.
+             * @return True if the connection is allowed (and counted); false
+             *         if the client is at its connection limit.
+             * @note Call Disconnect for every connection this allowed.
+             */
+            bool Connect( const ::std::string &a_client );
+
+            /**
+             * @brief Release a connection counted by Connect.
+             * @param a_client Client key passed to Connect.
+             */
+            void Disconnect( const ::std::string &a_client );
+
+            /**
+             * @brief Take one request token from a client's bucket.
+             * @param a_client Client key, such as its address.
+             * @return True if the request is allowed; false if the client is
+             *         over its rate.
+             */
+            bool Request( const ::std::string &a_client );
+    };
+}
+
+#endif // _RATELIMITER_HPP_
@@ -0,0 +1,84 @@
+/**
+    Sha1.hpp : Sha1 class definition
+    Description: Streaming SHA-1 digest.
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#pragma once
+
+#ifndef _SHA1_HPP_
+#define _SHA1_HPP_
+
+#include <utils/Types.hpp>
+#include <stddef.h>
+
+namespace utils
+{
+    /**
+     * @brief Streaming SHA-1 digest.
+     * @details Input is buffered one 64-byte block at a time, so hashing
+     *          any amount of data never allocates. Whole blocks are
+     *          compressed straight from the caller's memory. On x86 CPUs
+     *          with the SHA extensions the compression runs on the
+     *          dedicated instructions, chosen once at startup; elsewhere a
+     *          portable implementation is used.
+     * @note Not thread-safe; use one instance per thread. SHA-1 is suitable
+     *       for checksums and legacy formats such as htpasswd {SHA} entries,
+     *       not for new security designs.
+     */
+    class Sha1
+    {
+        public:
+            static const size_t DIGESTLEN = 20;
+
+        private:
+            uint32_t m_state[ 5 ];
+            uint8_t  m_block[ 64 ];
+            uint64_t m_length; // Bytes hashed so far
+            uint32_t m_used;   // Bytes waiting in m_block
+
+            static void Compress( uint32_t a_state[ 5 ], const uint8_t *a_blocks, size_t a_count );
+
+        public:
+            /**
+             * @brief Create a digest ready for input.
+             */
+            Sha1();
+
+            /**
+             * @brief Discard any input and start a new digest.
+             */
+            void Reset();
+
+            /**
+             * @brief Add data to the digest.
+             * @param a_data Data to hash.
+             * @param a_len Length of a_data in bytes.
+             */
+            void Update( const uint8_t *a_data, size_t a_len );
+
+            /**
+             * @brief Finish the digest.
+             * @param a_digest Receives the 20-byte digest.
+             * @note The object must be Reset before it is used again.
+             */
+            void Final( uint8_t a_digest[ DIGESTLEN ] );
+
+            /**
+             * @brief Hash a complete message in one call.
+             * @param a_data Data to hash.
+             * @param a_len Length of a_data in bytes.
+             * @param a_digest Receives the 20-byte digest.
+             */
+            static void Hash( const uint8_t *a_data, size_t a_len, uint8_t a_digest[ DIGESTLEN ] );
+
+            /**
+             * @brief Check whether the hardware SHA instructions are in use.
+             * @return True if blocks are compressed with the SHA extensions.
+             */
+            static bool Accelerated();
+    };
+}
+
+#endif // _SHA1_HPP_
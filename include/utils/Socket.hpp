@@ -10,8 +10,11 @@
 #include <utils/BitMask.hpp>
 #include <utils/Readable.hpp>
 #include <utils/Writable.hpp>
+#include <atomic>
 #include <memory>
 #include <netinet/in.h>
+#include <sys/socket.h>
+#include <optional>
 #include <string>
 
 #pragma once
@@ -31,6 +34,8 @@ namespace utils
         {
             Server    = 0,
             TCP       = 1,
+            ReusePort   = 2, // Servers: bind with SO_REUSEPORT to share the port
+            NonBlocking = 3, // Non-blocking descriptor; accepted sockets inherit it
             TcpClient = ( BIT(TCP)                             ),
             TcpServer = ( BIT(TCP) | BIT(Server)               ),
             UdpClient = ( 0                                    ),
@@ -43,16 +48,25 @@ namespace utils
      * @brief TCP/UDP socket wrapper implementing Readable/Writable.
      * @details Provides basic blocking/non-blocking reads and writes on a
      *          socket descriptor and handles client/server initialization.
-     * @note Not safe for concurrent access without external synchronization.
+     * @note Not safe for concurrent access without external synchronization,
+     *       except Interrupt, which may be called from any thread.
      */
     class Socket : public Readable,
                    public Writable
     {
         private:
-            int32_t  m_sockfd;
-            bool     m_valid;
-            int32_t  m_error;
-            BitMask  m_flags;
+            // Guards closing the descriptor against a concurrent Interrupt
+            struct Descriptor : public BasicLockable< SpinLockPolicy >
+            {
+            };
+
+            ::std::atomic< int32_t > m_sockfd;
+            bool                     m_valid;
+            int32_t                  m_error;
+            BitMask                  m_flags;
+            Descriptor               m_descriptor;
+            struct sockaddr_storage  m_peer;
+            socklen_t                m_peerLength;
 
         public:
             /**
@@ -67,8 +81,9 @@ namespace utils
              * @param a_address Hostname or address string; must be non-null.
              * @param a_port Port number.
              * @param a_flags Socket flags (e.g., TcpClient, TcpServer).
+             * @param a_backlog Pending-connection queue length for TCP servers.
              */
-            Socket( const char *a_address, uint32_t a_port, uint32_t a_flags = 0 );
+            Socket( const char *a_address, uint32_t a_port, uint32_t a_flags = 0, int32_t a_backlog = 100 );
 
             /**
              * @brief Destroy the socket wrapper and close the descriptor.
@@ -80,9 +95,27 @@ namespace utils
              * @brief Initialize the socket using host/service strings.
              * @param a_address Hostname or address string; must be non-null.
              * @param a_service Service or port string; must be non-null.
+             * @param a_backlog Pending-connection queue length for TCP servers.
              * @return 0 on success; non-zero on failure.
              */
-            int32_t Initialize( const char *a_address, const char *a_service );
+            int32_t Initialize( const char *a_address, const char *a_service, int32_t a_backlog );
+
+            /**
+             * @brief Set an integer socket option.
+             * @param a_level Protocol level (SOL_SOCKET, IPPROTO_TCP).
+             * @param a_name Option name.
+             * @param a_value Option value.
+             * @return True if the option was set; false otherwise.
+             */
+            bool    SetOption( int32_t a_level, int32_t a_name, int32_t a_value );
+
+            /**
+             * @brief Wait for poll events on the descriptor.
+             * @param a_events Events to wait for (POLLIN, POLLOUT, ...).
+             * @param a_timeoutMs Timeout in milliseconds; negative waits forever.
+             * @return True if an event (or hangup/error) is pending.
+             */
+            bool    WaitFor( int16_t a_events, int32_t a_timeoutMs );
 
         public:
             /**
@@ -91,6 +124,18 @@ namespace utils
              */
             bool    Valid();
 
+            /**
+             * @brief Accept an incoming connection on a listening socket.
+             * @details Uses accept4 with SOCK_CLOEXEC, plus SOCK_NONBLOCK when
+             *          the listener is NonBlocking. The peer address is kept
+             *          in binary form and only formatted by PeerAddress. On a
+             *          non-blocking listener, call in a loop until it returns
+             *          nullptr to drain every pending connection.
+             * @return New socket instance on success; nullptr when nothing is
+             *         pending (LastError is EAGAIN) or on failure.
+             */
+            ::std::shared_ptr< Socket > Accept();
+
             /**
              * @brief Accept an incoming connection on a listening socket.
              * @param a_address Output remote address string.
@@ -99,6 +144,77 @@ namespace utils
              */
             ::std::shared_ptr< Socket > Accept( ::std::string &a_address, uint32_t &a_port );
 
+            /**
+             * @brief Format the remote address of a connected socket.
+             * @param a_address Output remote address string.
+             * @param a_port Output remote port number.
+             * @return True if the peer address is known; false otherwise.
+             */
+            bool    PeerAddress( ::std::string &a_address, uint32_t &a_port );
+
+            /**
+             * @brief Wait until the socket is readable (or a listener has a
+             *        pending connection).
+             * @param a_timeoutMs Timeout in milliseconds; negative waits forever.
+             * @return True if readable or the socket was interrupted; false on
+             *         timeout.
+             */
+            bool    WaitForRead( int32_t a_timeoutMs );
+
+            // Socket options
+
+            /**
+             * @brief Enable or disable Nagle's algorithm (TCP_NODELAY).
+             * @param a_enable True to send small segments immediately.
+             * @return True if the option was set; false otherwise.
+             */
+            bool    SetNoDelay( bool a_enable );
+
+            /**
+             * @brief Wake a listener only once data arrives (TCP_DEFER_ACCEPT).
+             * @param a_seconds Seconds to wait for the first data; 0 disables.
+             * @return True if the option was set; false otherwise.
+             */
+            bool    SetDeferAccept( uint32_t a_seconds );
+
+            /**
+             * @brief Accept data in the SYN on a listener (TCP_FASTOPEN).
+             * @param a_queue Maximum pending fast-open requests; 0 disables.
+             * @return True if the option was set; false otherwise.
+             */
+            bool    SetFastOpen( uint32_t a_queue );
+
+            /**
+             * @brief Size the kernel send buffer (SO_SNDBUF).
+             * @param a_bytes Requested size; the kernel doubles and caps it.
+             * @return True if the option was set; false otherwise.
+             */
+            bool    SetSendBuffer( uint32_t a_bytes );
+
+            /**
+             * @brief Size the kernel receive buffer (SO_RCVBUF).
+             * @param a_bytes Requested size; the kernel doubles and caps it.
+             * @return True if the option was set; false otherwise.
+             */
+            bool    SetReceiveBuffer( uint32_t a_bytes );
+
+            /**
+             * @brief Limit unsent data queued in the kernel (TCP_NOTSENT_LOWAT).
+             * @param a_bytes Low-water mark before the socket reports writable.
+             * @return True if the option was set; false otherwise.
+             */
+            bool    SetNotSentLowat( uint32_t a_bytes );
+
+            /**
+             * @brief Configure TCP keepalive probes.
+             * @param a_enable True to enable keepalive (SO_KEEPALIVE).
+             * @param a_idle Idle seconds before the first probe; 0 keeps the default.
+             * @param a_interval Seconds between probes; 0 keeps the default.
+             * @param a_count Unanswered probes before dropping; 0 keeps the default.
+             * @return True if every requested option was set; false otherwise.
+             */
+            bool    SetKeepAlive( bool a_enable, uint32_t a_idle = 0, uint32_t a_interval = 0, uint32_t a_count = 0 );
+
             /**
              * @brief Retrieve the last socket error code.
              * @return Error code value.
@@ -110,6 +226,15 @@ namespace utils
              */
             void    Shutdown();
 
+            /**
+             * @brief Wake any thread blocked on this socket.
+             * @details Shuts the connection down without taking the socket
+             *          lock, so a blocked Accept returns nullptr and blocked
+             *          reads and writes fail; the owner then closes the
+             *          descriptor as usual.
+             */
+            void    Interrupt();
+
             // Read functions
 
             /**
@@ -195,6 +320,39 @@ namespace utils
              */
             bool     Write( ::std::shared_ptr< Buffer > &a_buffer ) noexcept;
     };
+
+    /**
+     * @brief A set of socket options to apply to one or more sockets.
+     * @details Only the options that hold a value are applied, so one set can
+     *          be built from configuration and applied to every listener or
+     *          accepted connection.
+     */
+    struct SocketOptions
+    {
+        ::std::optional< bool >     noDelay;
+        ::std::optional< uint32_t > deferAccept;
+        ::std::optional< uint32_t > fastOpen;
+        ::std::optional< uint32_t > sendBuffer;
+        ::std::optional< uint32_t > receiveBuffer;
+        ::std::optional< uint32_t > notSentLowat;
+        ::std::optional< bool >     keepAlive;
+        uint32_t                    keepIdle     = 0;
+        uint32_t                    keepInterval = 0;
+        uint32_t                    keepCount    = 0;
+
+        /**
+         * @brief Check whether any option is set.
+         * @return True if Apply would set at least one option.
+         */
+        bool Empty() const;
+
+        /**
+         * @brief Apply every option that holds a value.
+         * @param a_socket Socket to configure.
+         * @return True if all set options were applied; false otherwise.
+         */
+        bool Apply( Socket &a_socket ) const;
+    };
 }
 
 #endif // _SOCKET_HPP_
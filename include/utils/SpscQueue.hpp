@@ -0,0 +1,197 @@
+/**
+    SpscQueue.hpp : SpscQueue class definition
+    Description: Bounded lock-free single-producer/single-consumer queue.
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#pragma once
+
+#ifndef _SPSCQUEUE_HPP_
+#define _SPSCQUEUE_HPP_
+
+#include <utils/Types.hpp>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <stddef.h>
+#include <utility>
+
+namespace utils
+{
+    template< typename type >
+
+    /**
+     * @brief Bounded lock-free queue for exactly one producer and one consumer.
+     * @details A power-of-two ring with a head index owned by the consumer
+     *          and a tail index owned by the producer. Each side caches the
+     *          other's index and only re-reads it when the ring looks full or
+     *          empty, so the common case touches no shared cache line. Like
+     *          MpmcQueue, storage is preallocated and values are moved.
+     * @note Lock-free but only safe with a single producer thread and a single
+     *       consumer thread; use MpmcQueue otherwise.
+     */
+    class SpscQueue
+    {
+        private:
+            static constexpr size_t CacheLine = 64;
+
+            struct Slot
+            {
+                alignas( type ) unsigned char storage[ sizeof( type ) ];
+            };
+
+            ::std::unique_ptr< Slot[] >                  m_slots;
+            size_t                                       m_mask;
+            alignas( CacheLine ) ::std::atomic< size_t > m_head;
+            size_t                                       m_tailCache;
+            alignas( CacheLine ) ::std::atomic< size_t > m_tail;
+            size_t                                       m_headCache;
+
+            template< typename value >
+            bool Insert( value &&a_value )
+            {
+                size_t tail = m_tail.load( ::std::memory_order_relaxed );
+                if( ( tail - m_headCache ) > m_mask )
+                {
+                    m_headCache = m_head.load( ::std::memory_order_acquire );
+                    if( ( tail - m_headCache ) > m_mask )
+                    {
+                        // Full
+                        return false;
+                    }
+                }
+                new( m_slots[ tail & m_mask ].storage ) type( ::std::forward< value >( a_value ) );
+                m_tail.store( tail + 1, ::std::memory_order_release );
+                return true;
+            }
+
+        public:
+            /**
+             * @brief Construct a queue with room for at least a_capacity values.
+             * @param a_capacity Requested capacity; rounded up to a power of two
+             *                   (minimum 2).
+             */
+            SpscQueue( size_t a_capacity )
+            : m_slots()
+            , m_mask( 0 )
+            , m_head( 0 )
+            , m_tailCache( 0 )
+            , m_tail( 0 )
+            , m_headCache( 0 )
+            {
+                size_t capacity = 2;
+                while( capacity < a_capacity )
+                {
+                    capacity <<= 1;
+                }
+                m_slots = ::std::unique_ptr< Slot[] >( new Slot[ capacity ] );
+                m_mask  = capacity - 1;
+            }
+
+            SpscQueue( const SpscQueue & ) = delete;
+            SpscQueue &operator =( const SpscQueue & ) = delete;
+
+            /**
+             * @brief Destroy the queue and any values still in it.
+             */
+            ~SpscQueue()
+            {
+                size_t end = m_tail.load( ::std::memory_order_acquire );
+                for( size_t head = m_head.load( ::std::memory_order_acquire ); head != end; ++head )
+                {
+                    ::std::launder( reinterpret_cast< type * >( m_slots[ head & m_mask ].storage ) )->~type();
+                }
+            }
+
+            /**
+             * @brief Get the number of slots in the ring.
+             * @return Capacity after rounding.
+             */
+            size_t Capacity() const
+            {
+                return m_mask + 1;
+            }
+
+            /**
+             * @brief Get the approximate number of queued values.
+             * @return Snapshot of the element count.
+             */
+            size_t Length() const
+            {
+                size_t tail = m_tail.load( ::std::memory_order_acquire );
+                size_t head = m_head.load( ::std::memory_order_acquire );
+                return ( tail > head ) ? ( tail - head ) : 0;
+            }
+
+            /**
+             * @brief Enqueue a copy of a value at the back (producer only).
+             * @param a_value Value to copy into the queue.
+             * @return True if queued; false if the queue is full.
+             */
+            bool Enqueue( const type &a_value )
+            {
+                return Insert( a_value );
+            }
+
+            /**
+             * @brief Enqueue a value at the back by moving it (producer only).
+             * @param a_value Value to move into the queue; unchanged on failure.
+             * @return True if queued; false if the queue is full.
+             */
+            bool Enqueue( type &&a_value )
+            {
+                return Insert( ::std::move( a_value ) );
+            }
+
+            /**
+             * @brief Dequeue the value at the front (consumer only).
+             * @param a_value Output value; the element is moved into it.
+             * @return True if a value was removed; false if the queue is empty.
+             */
+            bool Dequeue( type &a_value )
+            {
+                size_t head = m_head.load( ::std::memory_order_relaxed );
+                if( head == m_tailCache )
+                {
+                    m_tailCache = m_tail.load( ::std::memory_order_acquire );
+                    if( head == m_tailCache )
+                    {
+                        // Empty
+                        return false;
+                    }
+                }
+                type *stored = ::std::launder( reinterpret_cast< type * >( m_slots[ head & m_mask ].storage ) );
+                a_value = ::std::move( *stored );
+                stored->~type();
+                m_head.store( head + 1, ::std::memory_order_release );
+                return true;
+            }
+
+            /**
+             * @brief Alias of Enqueue( const type & ); the queue is FIFO only.
+             */
+            bool Push( const type &a_value )
+            {
+                return Enqueue( a_value );
+            }
+
+            /**
+             * @brief Alias of Enqueue( type && ); the queue is FIFO only.
+             */
+            bool Push( type &&a_value )
+            {
+                return Enqueue( ::std::move( a_value ) );
+            }
+
+            /**
+             * @brief Alias of Dequeue; removes the oldest value.
+             */
+            bool Pop( type &a_value )
+            {
+                return Dequeue( a_value );
+            }
+    };
+}
+
+#endif // _SPSCQUEUE_HPP_
@@ -12,7 +12,12 @@
 
 #include <utils/Types.hpp>
 #include <utils/Lock.hpp>
+#include <algorithm>
 #include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace utils
 {
@@ -21,8 +26,10 @@ namespace utils
     /**
      * @brief Node for Staque linked list.
      * @details Holds a shared pointer to a value and links to neighbors.
+     *          Nodes carry no lock of their own; they are only reached
+     *          through the owning Staque, which guards them.
      */
-    class StaqueElement : public Lockable
+    class StaqueElement
     {
         private:
             ::std::shared_ptr< type >                  m_value;
@@ -49,6 +56,17 @@ namespace utils
             , m_previous()
             {}
 
+            /**
+             * @brief Construct a node, building its value from arguments.
+             * @param a_args Arguments forwarded to the value's constructor.
+             */
+            template< typename... args >
+            StaqueElement( ::std::in_place_t, args &&...a_args )
+            : m_value( ::std::make_shared< type >( ::std::forward< args >( a_args )... ) )
+            , m_next()
+            , m_previous()
+            {}
+
             /**
              * @brief Access the stored value.
              * @return Shared pointer to the value; may be null if unset.
@@ -80,11 +98,15 @@ namespace utils
     template< typename type >
 
     /**
-     * @brief Stack/queue hybrid container.
-     * @details Provides push/pop (stack) and enqueue/dequeue (queue) operations.
-     * @note Not safe for concurrent access without external synchronization.
+     * @brief Linked-list storage for Staque.
+     * @details Each value lives in its own StaqueElement node, so pushes and
+     *          pops never move other elements, but indexed access walks the
+     *          list from the front. Like StaqueBlocks it provides the
+     *          storage interface Staque uses: Length, EmplaceFront,
+     *          EmplaceBack, PopFront, Front, At, Clear and begin/end.
+     * @note Not thread-safe; Staque guards its storage.
      */
-    class Staque : public Lockable
+    class StaqueList
     {
         private:
             ::std::shared_ptr< StaqueElement< type > > m_start;
@@ -93,41 +115,73 @@ namespace utils
 
         public:
             /**
-             * @brief Construct an empty container.
+             * @brief Forward iterator over the values, front to back.
              */
-            Staque()
+            class Iterator
+            {
+                private:
+                    StaqueElement< type > *m_node;
+
+                public:
+                    Iterator( StaqueElement< type > *a_node )
+                    : m_node( a_node )
+                    {
+                    }
+
+                    type &operator *() const
+                    {
+                        return *( m_node->Value() );
+                    }
+
+                    type *operator ->() const
+                    {
+                        return m_node->Value().get();
+                    }
+
+                    Iterator &operator ++()
+                    {
+                        m_node = m_node->Next().get();
+                        return *this;
+                    }
+
+                    Iterator operator ++( int )
+                    {
+                        Iterator previous = *this;
+                        ++( *this );
+                        return previous;
+                    }
+
+                    bool operator ==( const Iterator &a_other ) const
+                    {
+                        return m_node == a_other.m_node;
+                    }
+            };
+
+            StaqueList()
             : m_length( 0 )
             {
             }
 
-            /**
-             * @brief Destroy the container and release nodes.
-             */
-            ~Staque()
+            Iterator begin()
             {
-                ::utils::Lock lock( this );
+                return Iterator( m_start.get() );
             }
 
-            /**
-             * @brief Get the current number of elements.
-             * @return Reference to the length count.
-             */
-            const uint32_t &Length()
+            Iterator end()
+            {
+                return Iterator( nullptr );
+            }
+
+            const uint32_t &Length() const
             {
-                ::utils::Lock lock( this );
                 return m_length;
             }
 
-            /**
-             * @brief Push a value onto the front (stack behavior).
-             * @param a_value Value to copy into the container.
-             * @return True if the value was added; false on allocation failure.
-             */
-            bool Push( type &a_value )
+            template< typename... args >
+            bool EmplaceFront( args &&...a_args )
             {
-                ::utils::Lock lock( this );
                 ::std::shared_ptr< StaqueElement< type > > temp =
-                    ::std::make_shared< StaqueElement< type > >( a_value );
+                    ::std::make_shared< StaqueElement< type > >( ::std::in_place, ::std::forward< args >( a_args )... );
                 bool ok = temp && temp->Value();
                 if( ok && !m_start )
                 {
@@ -145,18 +199,36 @@ namespace utils
                 return ok;
             }
 
-            /**
-             * @brief Pop a value from the front (stack behavior).
-             * @param a_value Output value to receive the removed element.
-             * @return True if an element was removed; false if empty.
-             */
-            bool Pop( type &a_value )
+            template< typename... args >
+            bool EmplaceBack( args &&...a_args )
+            {
+                ::std::shared_ptr< StaqueElement< type > > temp =
+                    ::std::make_shared< StaqueElement< type > >( ::std::in_place, ::std::forward< args >( a_args )... );
+                bool ok = temp && temp->Value();
+                if( ok && !m_end )
+                {
+                    m_start  = temp;
+                    m_end    = temp;
+                    m_length = 1;
+                }
+                else if( ok )
+                {
+                    m_end->Next()             = temp;
+                    m_end->Next()->Previous() = m_end;
+                    m_end                     = m_end->Next();
+                    ++m_length;
+                }
+                return ok;
+            }
+
+            template< typename output >
+            bool PopFront( output &a_value )
             {
-                ::utils::Lock lock( this );
                 bool ok = m_start && m_start->Value();
                 if( ok )
                 {
-                    a_value = *( m_start->Value() );
+                    // The node is being unlinked, so its value can be moved
+                    a_value = ::std::move( *( m_start->Value() ) );
                     m_start = m_start->Next();
                     if( m_start )
                     {
@@ -171,36 +243,391 @@ namespace utils
                 return ok;
             }
 
+            bool Front( type &a_value )
+            {
+                bool ok = m_start && m_start->Value();
+                if( ok )
+                {
+                    a_value = *( m_start->Value() );
+                }
+                return ok;
+            }
+
+            bool At( uint32_t a_index, type &a_value )
+            {
+                bool ok = ( a_index < m_length );
+                ::std::shared_ptr< StaqueElement< type > > start = m_start;
+                while( ok && start && ( a_index > 0 ) )
+                {
+                    start = start->Next();
+                    --a_index;
+                }
+                ok = ok && ( 0 == a_index ) && start && start->Value();
+                if( ok )
+                {
+                    a_value = *( start->Value() );
+                }
+                return ok;
+            }
+
+            void Clear()
+            {
+                m_start.reset();
+                m_end.reset();
+                m_length = 0;
+            }
+    };
+
+    template< typename type >
+
+    /**
+     * @brief Chunked contiguous storage for Staque.
+     * @details Values are stored inline in fixed-size blocks referenced from a
+     *          block map, like a std::deque: pushes at either end are
+     *          amortized O(1), existing values never move, and indexed access
+     *          is O(1). When one end of the map runs out the live blocks are
+     *          re-centered in a map sized to twice their count, which also
+     *          drops blocks a queue has already drained.
+     * @note Not thread-safe; Staque guards its storage.
+     */
+    class StaqueBlocks
+    {
+        private:
+            static constexpr uint32_t BlockSize = ( sizeof( type ) <= 16 ) ? 64 : ( ( sizeof( type ) <= 64 ) ? 16 : 4 );
+
+            struct Block
+            {
+                alignas( type ) unsigned char storage[ sizeof( type ) * BlockSize ];
+            };
+
+            ::std::vector< ::std::unique_ptr< Block > > m_map;
+            size_t                                      m_first;
+            uint32_t                                    m_length;
+
+            type *Slot( size_t a_slot )
+            {
+                return ::std::launder( reinterpret_cast< type * >(
+                    m_map[ a_slot / BlockSize ]->storage + ( ( a_slot % BlockSize ) * sizeof( type ) ) ) );
+            }
+
+            bool Reserve( size_t a_slot )
+            {
+                ::std::unique_ptr< Block > &block = m_map[ a_slot / BlockSize ];
+                if( !block )
+                {
+                    block.reset( new( ::std::nothrow ) Block );
+                }
+                return static_cast< bool >( block );
+            }
+
+            void Recenter()
+            {
+                size_t firstBlock = m_first / BlockSize;
+                size_t usedBlocks = ( m_length > 0 ) ? ( ( ( m_first + m_length - 1 ) / BlockSize ) - firstBlock + 1 ) : 1;
+                ::std::vector< ::std::unique_ptr< Block > > map( ::std::max< size_t >( 4, ( usedBlocks * 2 ) + 2 ) );
+                size_t offset = ( map.size() - usedBlocks ) / 2;
+                for( size_t i = 0; ( i < usedBlocks ) && ( ( firstBlock + i ) < m_map.size() ); ++i )
+                {
+                    map[ offset + i ] = ::std::move( m_map[ firstBlock + i ] );
+                }
+                m_first = ( offset * BlockSize ) + ( m_first % BlockSize );
+                m_map.swap( map );
+            }
+
+        public:
             /**
-             * @brief Enqueue a value to the back (queue behavior).
-             * @param a_value Value to copy into the container.
-             * @return True if the value was added; false on allocation failure.
+             * @brief Random-access position over the values, front to back.
              */
-            bool Enqueue( type &a_value )
+            class Iterator
             {
-                ::utils::Lock lock( this );
-                ::std::shared_ptr< StaqueElement< type > > temp =
-                    ::std::make_shared< StaqueElement< type > >( a_value );
-                bool ok = temp && temp->Value();
-                if( ok && !m_end )
+                private:
+                    StaqueBlocks *m_owner;
+                    size_t        m_slot;
+
+                public:
+                    Iterator( StaqueBlocks *a_owner, size_t a_slot )
+                    : m_owner( a_owner )
+                    , m_slot( a_slot )
+                    {
+                    }
+
+                    type &operator *() const
+                    {
+                        return *( m_owner->Slot( m_slot ) );
+                    }
+
+                    type *operator ->() const
+                    {
+                        return m_owner->Slot( m_slot );
+                    }
+
+                    Iterator &operator ++()
+                    {
+                        ++m_slot;
+                        return *this;
+                    }
+
+                    Iterator operator ++( int )
+                    {
+                        Iterator previous = *this;
+                        ++m_slot;
+                        return previous;
+                    }
+
+                    bool operator ==( const Iterator &a_other ) const
+                    {
+                        return ( m_owner == a_other.m_owner ) && ( m_slot == a_other.m_slot );
+                    }
+            };
+
+            StaqueBlocks()
+            : m_map()
+            , m_first( 0 )
+            , m_length( 0 )
+            {
+            }
+
+            Iterator begin()
+            {
+                return Iterator( this, m_first );
+            }
+
+            Iterator end()
+            {
+                return Iterator( this, m_first + m_length );
+            }
+
+            ~StaqueBlocks()
+            {
+                Clear();
+            }
+
+            StaqueBlocks( const StaqueBlocks & ) = delete;
+            StaqueBlocks &operator =( const StaqueBlocks & ) = delete;
+
+            const uint32_t &Length() const
+            {
+                return m_length;
+            }
+
+            template< typename... args >
+            bool EmplaceFront( args &&...a_args )
+            {
+                if( 0 == m_first )
                 {
-                    m_start  = temp;
-                    m_end    = temp;
-                    m_length = 1;
+                    Recenter();
                 }
-                else if( ok )
+                if( !Reserve( m_first - 1 ) )
                 {
-                    m_end->Next()             = temp;
-                    m_end->Next()->Previous() = m_end;
-                    m_end                     = m_end->Next();
-                    ++m_length;
+                    return false;
                 }
-                return ok;
+                new( Slot( m_first - 1 ) ) type( ::std::forward< args >( a_args )... );
+                --m_first;
+                ++m_length;
+                return true;
+            }
+
+            template< typename... args >
+            bool EmplaceBack( args &&...a_args )
+            {
+                if( ( m_first + m_length ) >= ( m_map.size() * BlockSize ) )
+                {
+                    Recenter();
+                }
+                if( !Reserve( m_first + m_length ) )
+                {
+                    return false;
+                }
+                new( Slot( m_first + m_length ) ) type( ::std::forward< args >( a_args )... );
+                ++m_length;
+                return true;
+            }
+
+            template< typename output >
+            bool PopFront( output &a_value )
+            {
+                if( 0 == m_length )
+                {
+                    return false;
+                }
+                type *value = Slot( m_first );
+                a_value = ::std::move( *value );
+                value->~type();
+                ++m_first;
+                --m_length;
+                return true;
+            }
+
+            bool Front( type &a_value )
+            {
+                return At( 0, a_value );
+            }
+
+            bool At( uint32_t a_index, type &a_value )
+            {
+                if( a_index >= m_length )
+                {
+                    return false;
+                }
+                a_value = *( Slot( m_first + a_index ) );
+                return true;
+            }
+
+            void Clear()
+            {
+                for( uint32_t i = 0; i < m_length; ++i )
+                {
+                    Slot( m_first + i )->~type();
+                }
+                m_map.clear();
+                m_first  = 0;
+                m_length = 0;
+            }
+    };
+
+    template< typename type, typename policy = RecursiveLockPolicy, template< typename > class storage = StaqueList >
+
+    /**
+     * @brief Stack/queue hybrid container.
+     * @details Provides push/pop (stack) and enqueue/dequeue (queue) operations.
+     *          The lock policy selects how the container synchronizes; use
+     *          NoLockPolicy for thread-confined instances. The storage
+     *          selects the layout: StaqueList (default) keeps a linked list of
+     *          nodes, StaqueBlocks keeps values inline in chunked blocks with
+     *          O(1) GetAt. Rvalue and Emplace overloads move or build
+     *          values in place, and Pop/Dequeue move them back out.
+     * @note Not safe for concurrent access without external synchronization.
+     *       Iteration does not lock; hold a utils::Lock on the container for
+     *       the whole loop if other threads may modify it.
+     */
+    class Staque : public BasicLockable< policy >
+    {
+        private:
+            storage< type > m_storage;
+
+        public:
+            typedef typename storage< type >::Iterator Iterator;
+
+            /**
+             * @brief Construct an empty container.
+             */
+            Staque()
+            : m_storage()
+            {
+            }
+
+            /**
+             * @brief Destroy the container and release its elements.
+             */
+            ~Staque()
+            {
+                ::utils::Lock lock( this );
+            }
+
+            /**
+             * @brief Get the current number of elements.
+             * @return Reference to the length count.
+             */
+            const uint32_t &Length()
+            {
+                ::utils::Lock lock( this );
+                return m_storage.Length();
+            }
+
+            /**
+             * @brief Push a copy of a value onto the front (stack behavior).
+             * @param a_value Value to copy into the container.
+             * @return True if the value was added; false on allocation failure.
+             */
+            bool Push( const type &a_value )
+            {
+                ::utils::Lock lock( this );
+                return m_storage.EmplaceFront( a_value );
+            }
+
+            /**
+             * @brief Move a value onto the front (stack behavior).
+             * @param a_value Value to move into the container.
+             * @return True if the value was added; false on allocation failure.
+             */
+            bool Push( type &&a_value )
+            {
+                ::utils::Lock lock( this );
+                return m_storage.EmplaceFront( ::std::move( a_value ) );
+            }
+
+            /**
+             * @brief Construct a value in place at the front (stack behavior).
+             * @param a_args Arguments forwarded to the value's constructor.
+             * @return True if the value was added; false on allocation failure.
+             */
+            template< typename... args >
+            bool EmplaceFront( args &&...a_args )
+            {
+                ::utils::Lock lock( this );
+                return m_storage.EmplaceFront( ::std::forward< args >( a_args )... );
+            }
+
+            /**
+             * @brief Pop a value from the front (stack behavior).
+             * @param a_value Output value; the element is moved into it.
+             * @return True if an element was removed; false if empty.
+             */
+            bool Pop( type &a_value )
+            {
+                ::utils::Lock lock( this );
+                return m_storage.PopFront( a_value );
+            }
+
+            /**
+             * @brief Pop a value from the front if there is one.
+             * @return The removed element, or an empty optional if empty.
+             */
+            ::std::optional< type > TryPop()
+            {
+                ::utils::Lock lock( this );
+                ::std::optional< type > value;
+                m_storage.PopFront( value );
+                return value;
+            }
+
+            /**
+             * @brief Enqueue a copy of a value to the back (queue behavior).
+             * @param a_value Value to copy into the container.
+             * @return True if the value was added; false on allocation failure.
+             */
+            bool Enqueue( const type &a_value )
+            {
+                ::utils::Lock lock( this );
+                return m_storage.EmplaceBack( a_value );
+            }
+
+            /**
+             * @brief Move a value to the back (queue behavior).
+             * @param a_value Value to move into the container.
+             * @return True if the value was added; false on allocation failure.
+             */
+            bool Enqueue( type &&a_value )
+            {
+                ::utils::Lock lock( this );
+                return m_storage.EmplaceBack( ::std::move( a_value ) );
+            }
+
+            /**
+             * @brief Construct a value in place at the back (queue behavior).
+             * @param a_args Arguments forwarded to the value's constructor.
+             * @return True if the value was added; false on allocation failure.
+             */
+            template< typename... args >
+            bool Emplace( args &&...a_args )
+            {
+                ::utils::Lock lock( this );
+                return m_storage.EmplaceBack( ::std::forward< args >( a_args )... );
             }
 
             /**
              * @brief Dequeue a value from the front (queue behavior).
-             * @param a_value Output value to receive the removed element.
+             * @param a_value Output value; the element is moved into it.
              * @return True if an element was removed; false if empty.
              */
             bool Dequeue( type &a_value )
@@ -208,6 +635,15 @@ namespace utils
                 return Pop( a_value );
             }
 
+            /**
+             * @brief Dequeue a value from the front if there is one.
+             * @return The removed element, or an empty optional if empty.
+             */
+            ::std::optional< type > TryDequeue()
+            {
+                return TryPop();
+            }
+
             /**
              * @brief Peek at the front element without removing it.
              * @param a_value Output value to receive the element.
@@ -216,26 +652,21 @@ namespace utils
             bool Peek( type &a_value )
             {
                 ::utils::Lock lock( this );
-                bool ok = m_start && m_start->Value();
-                if( ok )
-                {
-                    a_value = *( m_start->Value() );
-                }
-                return ok;
+                return m_storage.Front( a_value );
             }
 
             /**
              * @brief Clear all elements from the container.
-             * @note Does not change the allocated nodes beyond releasing references.
              */
             void Clear()
             {
-                m_start.reset();
-                m_end.reset();
+                ::utils::Lock lock( this );
+                m_storage.Clear();
             }
 
             /**
              * @brief Retrieve a value at a specific index.
+             * @details O(1) with StaqueBlocks; walks the list with StaqueList.
              * @param a_index Zero-based index from the front.
              * @param a_value Output value to receive the element.
              * @return True if the index is valid and value retrieved; false otherwise.
@@ -243,19 +674,25 @@ namespace utils
             bool GetAt( uint32_t a_index, type &a_value )
             {
                 ::utils::Lock lock( this );
-                bool ok = ( a_index < m_length );
-                ::std::shared_ptr< StaqueElement< type > > start = m_start;
-                while( ok && start && ( a_index > 0 ) )
-                {
-                    start = start->Next();
-                    --a_index;
-                }
-                ok = ok && ( 0 == a_index ) && start && start->Value();
-                if( ok )
-                {
-                    a_value = *( start->Value() );
-                }
-                return ok;
+                return m_storage.At( a_index, a_value );
+            }
+
+            /**
+             * @brief Iterator to the front element.
+             * @return Iterator usable in range-based for loops.
+             */
+            Iterator begin()
+            {
+                return m_storage.begin();
+            }
+
+            /**
+             * @brief Iterator past the back element.
+             * @return End iterator.
+             */
+            Iterator end()
+            {
+                return m_storage.end();
             }
     };
 }
@@ -0,0 +1,219 @@
+/**
+    TaskScheduler.hpp : TaskScheduler class definition
+    Description: Work-stealing task executor built on utils::Thread.
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#pragma once
+
+#ifndef _TASKSCHEDULER_HPP_
+#define _TASKSCHEDULER_HPP_
+
+#include <utils/Types.hpp>
+#include <utils/MpmcQueue.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace utils
+{
+    /**
+     * @brief Work-stealing executor for many small tasks.
+     * @details Runs a fixed set of worker threads. Each worker owns a
+     *          Chase-Lev deque: tasks posted from a worker go to the bottom of
+     *          its own deque and are taken LIFO for locality, while idle
+     *          workers steal FIFO from the top of other workers' deques.
+     *          Tasks posted from other threads go through a bounded
+     *          MpmcQueue. Workers spin briefly when out of work and then park
+     *          on a condition variable until new tasks arrive.
+     *
+     *          Submit wraps a callable in a std::packaged_task and returns its
+     *          std::future; Post is fire-and-forget; ParallelFor splits an
+     *          index range into chunks and has the calling thread work on
+     *          chunks too, so it is safe to call from inside a task.
+     * @note Thread-safe. When the injection queue is full, Post runs the task
+     *       on the calling thread rather than blocking. Tasks should not
+     *       block on futures of other tasks; use ParallelFor for fork/join.
+     */
+    class TaskScheduler
+    {
+        public:
+            typedef ::std::move_only_function< void() > Task;
+
+        private:
+            class Worker;
+
+            ::std::vector< ::std::unique_ptr< Worker > > m_workers;
+            MpmcQueue< Task * >                          m_injection;
+            ::std::vector< int32_t >                     m_cpus;
+            ::std::atomic< int64_t >                     m_pending;
+            ::std::atomic< uint32_t >                    m_idle;
+            ::std::atomic< bool >                        m_stopping;
+            ::std::mutex                                 m_parkMutex;
+            ::std::condition_variable                    m_park;
+
+            void  Wake();
+            Task *FindWork( uint32_t a_self, uint64_t &a_seed );
+            bool  RunOne();
+            static void *Run( void *a_context );
+
+        public:
+            /**
+             * @brief Start a scheduler with one worker per available CPU.
+             */
+            TaskScheduler();
+
+            /**
+             * @brief Start a scheduler with a chosen number of workers.
+             * @param a_workers Worker count; zero selects one per CPU.
+             * @param a_pinWorkers Pin worker N to the Nth CPU the process may
+             *                     run on (wrapping around).
+             * @param a_queueCapacity Capacity of the cross-thread injection
+             *                        queue.
+             */
+            TaskScheduler( uint32_t a_workers, bool a_pinWorkers = false, uint32_t a_queueCapacity = 4096 );
+
+            TaskScheduler( const TaskScheduler & ) = delete;
+            TaskScheduler &operator =( const TaskScheduler & ) = delete;
+
+            /**
+             * @brief Run all queued tasks, then stop and join the workers.
+             */
+            ~TaskScheduler();
+
+            /**
+             * @brief Get the number of worker threads.
+             * @return Worker count.
+             */
+            uint32_t Workers() const;
+
+            /**
+             * @brief Get the scheduler whose worker is running the caller.
+             * @return Scheduler pointer, or nullptr off worker threads.
+             */
+            static TaskScheduler *Current();
+
+            /**
+             * @brief Queue a task without tracking its result.
+             * @param a_task Task to run; exceptions it throws are discarded.
+             * @return True if queued; false if it ran inline or was empty.
+             */
+            bool Post( Task &&a_task );
+
+            /**
+             * @brief Queue a callable and obtain a future for its result.
+             * @param a_function Callable to run on a worker.
+             * @param a_args Arguments stored by value and passed on invocation.
+             * @return Future that receives the result or thrown exception.
+             */
+            template< typename function, typename... args >
+            auto Submit( function &&a_function, args &&...a_args )
+                -> ::std::future< ::std::invoke_result_t< ::std::decay_t< function >, ::std::decay_t< args >... > >
+            {
+                typedef ::std::invoke_result_t< ::std::decay_t< function >, ::std::decay_t< args >... > result;
+                ::std::packaged_task< result() > task(
+                    [ call = ::std::forward< function >( a_function ),
+                      params = ::std::make_tuple( ::std::forward< args >( a_args )... ) ]() mutable -> result
+                    {
+                        return ::std::apply( call, ::std::move( params ) );
+                    } );
+                ::std::future< result > future = task.get_future();
+                Post( Task( ::std::move( task ) ) );
+                return future;
+            }
+
+            /**
+             * @brief Call a_body( i ) for every i in [a_begin, a_end) in parallel.
+             * @details The range is split into chunks of a_grain indices that
+             *          workers and the calling thread claim until none are
+             *          left. Returns once every chunk has finished. If a_body
+             *          throws, chunks not yet started are skipped and the
+             *          first exception is rethrown here once every chunk is
+             *          accounted for, so no helper still uses a_body.
+             * @param a_begin First index.
+             * @param a_end One past the last index.
+             * @param a_grain Indices per chunk; zero is treated as one.
+             * @param a_body Callable taking a size_t index.
+             */
+            template< typename function >
+            void ParallelFor( size_t a_begin, size_t a_end, size_t a_grain, function &&a_body )
+            {
+                if( a_end <= a_begin )
+                {
+                    return;
+                }
+                struct State
+                {
+                    ::std::atomic< size_t > next;
+                    ::std::atomic< size_t > done;
+                    ::std::atomic< bool >   failed;
+                    ::std::exception_ptr    error; // First exception; written once by whoever set failed
+                };
+                size_t grain  = ::std::max< size_t >( 1, a_grain );
+                size_t chunks = ( ( a_end - a_begin ) + grain - 1 ) / grain;
+                auto   state  = ::std::make_shared< State >();
+                auto   body   = &a_body;
+                state->next.store( 0 );
+                state->done.store( 0 );
+                state->failed.store( false );
+
+                // Helpers that start after every chunk is claimed return
+                // without touching a_body, so it may live on our stack.
+                auto work = [ state, body, chunks, grain, a_begin, a_end ]()
+                {
+                    size_t chunk = 0;
+                    while( ( chunk = state->next.fetch_add( 1, ::std::memory_order_relaxed ) ) < chunks )
+                    {
+                        size_t first = a_begin + ( chunk * grain );
+                        size_t last  = ::std::min( a_end, first + grain );
+                        try
+                        {
+                            for( size_t i = first; ( i < last ) && !state->failed.load( ::std::memory_order_relaxed ); ++i )
+                            {
+                                ( *body )( i );
+                            }
+                        }
+                        catch( ... )
+                        {
+                            if( !state->failed.exchange( true ) )
+                            {
+                                state->error = ::std::current_exception();
+                            }
+                        }
+                        // Counted even after a throw, or the caller would wait forever
+                        state->done.fetch_add( 1, ::std::memory_order_release );
+                    }
+                };
+                size_t helpers = ::std::min< size_t >( chunks - 1, Workers() );
+                for( size_t i = 0; i < helpers; ++i )
+                {
+                    Post( Task( work ) );
+                }
+                work();
+                while( state->done.load( ::std::memory_order_acquire ) < chunks )
+                {
+                    if( !RunOne() )
+                    {
+                        ::std::this_thread::yield();
+                    }
+                }
+                if( state->error )
+                {
+                    ::std::rethrow_exception( state->error );
+                }
+            }
+    };
+}
+
+#endif // _TASKSCHEDULER_HPP_
@@ -7,8 +7,14 @@
 
 #include <utils/Lock.hpp>
 #include <pthread.h>
+#include <sched.h>
 #include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
 #include <memory>
+#include <stop_token>
+#include <string>
 
 #pragma once
 
@@ -22,18 +28,101 @@ namespace utils
     /**
      * @brief Simple pthread wrapper with a shared context object.
      * @details Owns a thread function pointer and a shared context passed as
-     *          the argument. The thread is joinable by default.
+     *          the argument. The thread is joinable by default. Stack size,
+     *          CPU affinity, name, and scheduling policy may be set before
+     *          Start and apply to every later start. Each wrapper owns a stop
+     *          source; hand GetStopToken() to the thread through its context
+     *          and have it return once StopRequested() is seen.
      * @note Not safe for concurrent access without external synchronization.
      */
     class Thread : public Lockable
     {
         private:
+            // Everything the new thread needs, handed over by value so the
+            // thread never reads the wrapper's members
+            struct Launch
+            {
+                void          *( *function ) ( void * );
+                void           *context;
+                ::std::string   name;
+                int32_t         policy;
+                int32_t         priority;
+                bool            schedule;
+            };
+
+            // Apply the per-thread settings from inside the thread before
+            // running the entry point
+            static void *Entry( void *a_launch )
+            {
+                Launch *launch = reinterpret_cast< Launch * >( a_launch );
+                if( launch->name.length() > 0 )
+                {
+                    pthread_setname_np( pthread_self(), launch->name.c_str() );
+                }
+                if( launch->schedule )
+                {
+                    sched_param parameters{};
+                    parameters.sched_priority = launch->priority;
+                    pthread_setschedparam( pthread_self(), launch->policy, &parameters );
+                }
+                void *( *function ) ( void * ) = launch->function;
+                void *context = launch->context;
+                delete launch;
+                return function( context );
+            }
+
+            // Parse a kernel-style CPU list ("0-3,8,10-11") into a set
+            static bool ParseCpuList( const char *a_list, cpu_set_t &a_cpus )
+            {
+                bool        any     = false;
+                const char *current = a_list;
+                while( ( nullptr != current ) && ( '\0' != *current ) && ( '\n' != *current ) )
+                {
+                    char *end   = nullptr;
+                    long  first = strtol( current, &end, 10 );
+                    long  last  = first;
+                    if( ( end == current ) || ( first < 0 ) )
+                    {
+                        return false;
+                    }
+                    current = end;
+                    if( '-' == *current )
+                    {
+                        last = strtol( current + 1, &end, 10 );
+                        if( ( end == ( current + 1 ) ) || ( last < first ) )
+                        {
+                            return false;
+                        }
+                        current = end;
+                    }
+                    if( last >= CPU_SETSIZE )
+                    {
+                        return false;
+                    }
+                    for( long cpu = first; cpu <= last; ++cpu )
+                    {
+                        CPU_SET( cpu, &a_cpus );
+                        any = true;
+                    }
+                    while( ( ',' == *current ) || ( ' ' == *current ) )
+                    {
+                        ++current;
+                    }
+                }
+                return any;
+            }
+
             pthread_t                  m_thread;
             pthread_attr_t             m_attributes;
             ::std::shared_ptr< type >  m_context;
             bool                       m_ok;
             bool                       m_running;
             void                      *( *m_function ) ( void * );
+            ::std::string              m_name;
+            int32_t                    m_policy;
+            int32_t                    m_priority;
+            bool                       m_schedule;
+            ::std::stop_source         m_stop;
 
         public:
             /**
@@ -45,8 +134,11 @@ namespace utils
                 m_context  = ::std::make_shared< type >();
                 m_function = a_function;
                 m_running  = false;
+                m_policy   = SCHED_OTHER;
+                m_priority = 0;
+                m_schedule = false;
                 m_ok = ( nullptr != m_function );
-                m_ok = ( nullptr != m_context );
+                m_ok = m_ok && ( nullptr != m_context );
                 m_ok = m_ok && ( 0 == pthread_attr_init( &m_attributes ) );
                 m_ok = m_ok && ( 0 == pthread_attr_setdetachstate( &m_attributes, PTHREAD_CREATE_JOINABLE ) );
             }
@@ -70,6 +162,91 @@ namespace utils
                 return m_context;
             }
 
+            /**
+             * @brief Set the stack size used when the thread starts.
+             * @param a_bytes Stack size in bytes; raised to PTHREAD_STACK_MIN.
+             * @return True if the size was accepted; false otherwise.
+             */
+            bool SetStackSize( size_t a_bytes )
+            {
+                utils::Lock lock( this );
+                if( a_bytes < static_cast< size_t >( PTHREAD_STACK_MIN ) )
+                {
+                    a_bytes = static_cast< size_t >( PTHREAD_STACK_MIN );
+                }
+                return m_ok && ( 0 == pthread_attr_setstacksize( &m_attributes, a_bytes ) );
+            }
+
+            /**
+             * @brief Restrict the thread to a set of CPUs.
+             * @param a_cpus CPU list such as "0-3,8"; must be non-null.
+             * @return True if the list was valid and applied; false otherwise.
+             */
+            bool SetAffinity( const char *a_cpus )
+            {
+                utils::Lock lock( this );
+                cpu_set_t cpus;
+                CPU_ZERO( &cpus );
+                if( !m_ok || !ParseCpuList( a_cpus, cpus ) )
+                {
+                    return false;
+                }
+                return ( 0 == pthread_attr_setaffinity_np( &m_attributes, sizeof( cpus ), &cpus ) );
+            }
+
+            /**
+             * @brief Restrict the thread to the CPUs of a NUMA node.
+             * @param a_node Node number as listed under /sys/devices/system/node.
+             * @return True if the node was found and applied; false otherwise.
+             */
+            bool SetNumaNode( uint32_t a_node )
+            {
+                char path[ 64 ];
+                char cpus[ 1024 ];
+                snprintf( path, sizeof( path ), "/sys/devices/system/node/node%u/cpulist", a_node );
+                FILE *file = fopen( path, "r" );
+                if( nullptr == file )
+                {
+                    return false;
+                }
+                bool ok = ( nullptr != fgets( cpus, sizeof( cpus ), file ) );
+                fclose( file );
+                return ok && SetAffinity( cpus );
+            }
+
+            /**
+             * @brief Name the thread as shown by top -H and debuggers.
+             * @param a_name Thread name; truncated to 15 characters.
+             */
+            void SetName( const ::std::string &a_name )
+            {
+                utils::Lock lock( this );
+                m_name = a_name.substr( 0, 15 );
+            }
+
+            /**
+             * @brief Set the scheduling policy applied once the thread starts.
+             * @param a_policy SCHED_OTHER, SCHED_BATCH, SCHED_IDLE, SCHED_FIFO, or SCHED_RR.
+             * @param a_priority Static priority; must be 0 except for FIFO/RR.
+             * @return True if the policy and priority are valid; false otherwise.
+             * @note Real-time policies need CAP_SYS_NICE; if the change is
+             *       refused the thread keeps running with the default policy.
+             */
+            bool SetSchedule( int32_t a_policy, int32_t a_priority )
+            {
+                utils::Lock lock( this );
+                int32_t minimum = sched_get_priority_min( a_policy );
+                int32_t maximum = sched_get_priority_max( a_policy );
+                if( ( minimum < 0 ) || ( maximum < 0 ) || ( a_priority < minimum ) || ( a_priority > maximum ) )
+                {
+                    return false;
+                }
+                m_policy   = a_policy;
+                m_priority = a_priority;
+                m_schedule = true;
+                return true;
+            }
+
             /**
              * @brief Start the thread.
              * @return True on success; false if already running or on error.
@@ -77,8 +254,13 @@ namespace utils
             bool Start()
             {
                 utils::Lock lock( this );
-                m_ok = m_ok && ( 0 == pthread_create( &m_thread, &m_attributes, m_function, ( void * ) &( *m_context ) ) );
+                Launch *launch = new Launch{ m_function, m_context.get(), m_name, m_policy, m_priority, m_schedule };
+                m_ok = m_ok && ( 0 == pthread_create( &m_thread, &m_attributes, Entry, launch ) );
                 m_running = m_ok;
+                if( !m_running )
+                {
+                    delete launch;
+                }
                 return m_ok;
             }
 
@@ -95,28 +277,59 @@ namespace utils
             }
 
             /**
-             * @brief Send SIGKILL to the running thread.
+             * @brief Get a token that reports when a stop has been requested.
+             * @return Stop token shared with this wrapper's stop source.
+             */
+            ::std::stop_token GetStopToken() const
+            {
+                return m_stop.get_token();
+            }
+
+            /**
+             * @brief Ask the thread to finish its work and return.
+             * @details Cooperative: the thread observes the request through its
+             *          stop token; std::stop_callback registrations run here.
+             * @return True if this call made the request; false if already made.
+             */
+            bool RequestStop()
+            {
+                return m_stop.request_stop();
+            }
+
+            /**
+             * @brief Check whether a stop has been requested.
+             * @return True once RequestStop has been called.
+             */
+            bool StopRequested() const
+            {
+                return m_stop.stop_requested();
+            }
+
+            /**
+             * @brief Request a stop, then cancel the thread if it is still running.
+             * @details Replaces the former SIGKILL, which terminated the whole
+             *          process rather than the thread.
              * @return True on success; false if not running or on error.
-             * @warning Forcibly terminating a thread can leak resources.
+             * @warning Cancellation can leak resources; prefer RequestStop
+             *          and Join.
              */
             bool Kill()
             {
                 utils::Lock lock( this );
-                m_ok = m_ok && m_running && ( 0 == pthread_kill( m_thread, SIGKILL ) );
-                m_running = !m_ok;
-                return m_ok;
+                RequestStop();
+                return Cancel();
             }
 
             /**
              * @brief Request cancellation of the running thread.
+             * @details The thread stays joinable; Join (or the destructor)
+             *          reaps it once cancellation completes.
              * @return True on success; false if not running or on error.
              */
             bool Cancel()
             {
                 utils::Lock lock( this );
-                m_ok = m_ok && m_running && ( 0 == pthread_cancel( m_thread ) );
-                m_running = !m_ok;
-                return m_ok;
+                return m_ok && m_running && ( 0 == pthread_cancel( m_thread ) );
             }
     };
 }
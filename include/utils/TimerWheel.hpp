@@ -0,0 +1,151 @@
+/**
+    TimerWheel.hpp : TimerWheel class definition
+    Description: Hierarchical timing wheel for deadlines and timeouts.
+    Copyright 2026 Daniel Wilson
+    SPDX-License-Identifier: MIT
+*/
+
+#pragma once
+
+#ifndef _TIMERWHEEL_HPP_
+#define _TIMERWHEEL_HPP_
+
+#include <utils/Types.hpp>
+#include <utils/Lockable.hpp>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+namespace utils
+{
+    /**
+     * @brief Hierarchical timing wheel driven by the caller's loop.
+     * @details Time is divided into ticks of a fixed resolution. Timers live
+     *          in one of four wheels of 64 slots each; the first wheel holds
+     *          timers due within 64 ticks, and each higher wheel covers 64
+     *          times the span of the one below it. When the first wheel wraps,
+     *          the next slot of the wheel above is cascaded down, so every
+     *          timer is moved at most three times before it fires. Timers are
+     *          kept in intrusive slot lists indexed into a node pool, making
+     *          Schedule, Cancel, and Reschedule O(1).
+     *
+     *          Nothing runs on its own: an I/O loop calls Tick to run the
+     *          timers that are due and uses NextTimeout as its poll timeout.
+     *          Timer ids carry a generation count, so cancelling a timer that
+     *          already fired (or whose slot was reused) does nothing.
+     * @note Thread-safe. Callbacks run on the thread calling Tick, after the
+     *       wheel's lock is released, so they may schedule or cancel timers.
+     *       Delays beyond the wheel's range (2^24 ticks) are re-filed as they
+     *       approach rather than clamped.
+     */
+    class TimerWheel : public Lockable
+    {
+        public:
+            typedef ::std::move_only_function< void() > Callback;
+            typedef uint64_t                            TimerId;  // Zero is never a valid id
+            typedef ::std::chrono::steady_clock         Clock;
+
+        private:
+            static const uint32_t WHEELS = 4;
+            static const uint32_t BITS   = 6;
+            static const uint32_t SLOTS  = 1 << BITS;
+
+            struct Node
+            {
+                Callback callback;
+                uint64_t expiry     = 0; // Tick the timer is due on
+                uint32_t generation = 1;
+                int32_t  prev       = -1;
+                int32_t  next       = -1;
+                int32_t  slot       = -1; // Wheel * SLOTS + slot, or -1 when free
+            };
+
+            ::std::vector< Node >    m_nodes;
+            ::std::vector< int32_t > m_free;
+            int32_t                  m_heads[ WHEELS * SLOTS ];
+            uint64_t                 m_occupied[ WHEELS ]; // Non-empty slot bits per wheel
+            uint64_t                 m_now;                // Last tick processed
+            uint32_t                 m_count;
+            uint32_t                 m_resolution;         // Milliseconds per tick
+            Clock::time_point        m_epoch;
+
+            uint64_t Elapsed( Clock::time_point a_now ) const;
+            uint64_t Expiry( uint32_t a_delayMs ) const;
+            int32_t  Find( TimerId a_id ) const;
+            void     Link( int32_t a_index );
+            void     Unlink( int32_t a_index );
+            void     Release( int32_t a_index );
+            void     Cascade( uint32_t a_wheel );
+            void     Step( ::std::vector< Callback > &a_due );
+
+        public:
+            /**
+             * @brief Create an empty wheel.
+             * @param a_resolutionMs Tick length in milliseconds; zero is
+             *                       treated as one.
+             */
+            TimerWheel( uint32_t a_resolutionMs = 10 );
+
+            TimerWheel( const TimerWheel & ) = delete;
+            TimerWheel &operator =( const TimerWheel & ) = delete;
+
+            /**
+             * @brief Run a callback once after a delay.
+             * @param a_delayMs Delay in milliseconds, rounded up to whole
+             *                  ticks (at least one).
+             * @param a_callback Callback to run from Tick.
+             * @return Timer id, or zero if the callback was empty.
+             */
+            TimerId  Schedule( uint32_t a_delayMs, Callback &&a_callback );
+
+            /**
+             * @brief Move a pending timer to a new delay from now.
+             * @details Suited to idle timeouts that are pushed back on
+             *          activity.
+             * @param a_id Timer id from Schedule.
+             * @param a_delayMs New delay in milliseconds.
+             * @return True if the timer was pending; false otherwise.
+             */
+            bool     Reschedule( TimerId a_id, uint32_t a_delayMs );
+
+            /**
+             * @brief Cancel a pending timer without running it.
+             * @param a_id Timer id from Schedule.
+             * @return True if the timer was pending; false otherwise.
+             */
+            bool     Cancel( TimerId a_id );
+
+            /**
+             * @brief Check whether a timer is still pending.
+             * @param a_id Timer id from Schedule.
+             * @return True if the timer has neither fired nor been cancelled.
+             */
+            bool     Pending( TimerId a_id );
+
+            /**
+             * @brief Advance the wheel to a_now and run every timer due.
+             * @param a_now Current time.
+             * @return Number of callbacks run.
+             */
+            uint32_t Tick( Clock::time_point a_now = Clock::now() );
+
+            /**
+             * @brief Get how long a loop may wait before it must call Tick.
+             * @details Exact for timers in the first wheel; otherwise the
+             *          time until the next cascade, which is never later
+             *          than the earliest timer.
+             * @param a_maxMs Upper bound on the result.
+             * @return Milliseconds to wait, or a_maxMs if no timer is pending
+             *         (or none is due sooner).
+             */
+            int32_t  NextTimeout( int32_t a_maxMs = -1 );
+
+            /**
+             * @brief Get the number of pending timers.
+             * @return Pending timer count.
+             */
+            uint32_t Size();
+    };
+}
+
+#endif // _TIMERWHEEL_HPP_
@@ -21,6 +21,8 @@
 #include <utils/BitMask.hpp>
 #include <utils/Buffer.hpp>
 #include <utils/Staque.hpp>
+#include <utils/MpmcQueue.hpp>
+#include <utils/SpscQueue.hpp>
 
 // Complex types
 #include <utils/File.hpp>